@@ -1,5 +1,6 @@
 // frameworks
 #include "ion/system.hpp"
+#include "ion/timer.hpp"
 #include "ion/ui.hpp"
 #include <SDL2/SDL.h>
 #include <entt/entity/registry.hpp>
@@ -11,8 +12,10 @@
 #include "gold/size.hpp"
 #include "gold/background_color.hpp"
 #include "gold/widget.hpp"
+#include "gold/snapshot.hpp"
 
 // data types and structure
+#include <memory_resource>
 #include <string>
 #include <vector>
 #include <variant>
@@ -22,6 +25,7 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <future>
 namespace fs = std::filesystem;
 
 // type constraints and algorithms
@@ -43,6 +47,7 @@ void print_error(std::string const & message) {
 namespace global {
 bool show_demo = false;
 bool show_editor = false;
+bool show_statistics = false;
 }
 
 inline namespace gold {
@@ -65,9 +70,7 @@ void show_options(align_enum & selected_option) {
     float const width = ImGui::CalcTextSize("bottom").x;
 
     for (int i = 0; i < 4; ++i) {
-        using namespace std::string_literals;
-        std::string const col_name = "align-"s + std::to_string(i);
-        ImGui::TableSetupColumn(col_name.c_str(),
+        ImGui::TableSetupColumn(ImGui::FormatLabel<"align-{}">(i),
                                 ImGuiTableColumnFlags_WidthFixed,
                                 width + padding);
     }
@@ -136,6 +139,23 @@ void show_options(gold::background_color & color) {
     color.blue = color_values[2];
     color.alpha = color_values[3];
 }
+
+// compact components are edited in their regular form
+void show_options(gold::compact_layout & layout) {
+    auto expanded = gold::expand(layout);
+    show_options(expanded);
+    layout = gold::compact(expanded);
+}
+void show_options(gold::compact_size & size) {
+    auto expanded = gold::expand(size);
+    show_options(expanded);
+    size = gold::compact(expanded);
+}
+void show_options(gold::compact_background_color & color) {
+    auto expanded = gold::expand(color);
+    show_options(expanded);
+    color = gold::compact(expanded);
+}
 }
 namespace ImGui {
 
@@ -148,10 +168,10 @@ void ShowSaveOption(entt::registry & widgets, entt::entity widget)
     ImGui::InputText("##Widget-Path-Input", widget_filename,
                      IM_ARRAYSIZE(widget_filename));
 
-    auto const widget_path = paths::assets/widget_filename;
     ImGui::SameLine();
     static std::string saved_to;
     if (ImGui::Button("Save")) {
+        auto const widget_path = paths::assets/widget_filename;
         YAML::Emitter out;
         gold::write(out, widgets, widget);
         std::ofstream file{ widget_path.string(), std::ios_base::trunc };
@@ -166,47 +186,48 @@ void ShowSaveOption(entt::registry & widgets, entt::entity widget)
         ImGui::Unindent();
     }
 }
-template<gold::editor_option component>
-requires gold::has_public_name<component>
-std::optional<component>
-ComboOption(entt::registry & widgets, entt::entity widget,
-            std::string_view & selected_component)
+void ShowSnapshotOption(gold::editor & editor)
 {
-    std::string_view constexpr name = component_info<component>::public_name;
-    if (widgets.any_of<component>(widget)) {
-        return std::nullopt;
+    auto & widgets = editor.widgets;
+    ImGui::Text("Snapshot");
+    ImGui::Spacing();
+    ImGui::Indent();
+
+    // swapping with the stored snapshot toggles between two widget states
+    static gold::snapshot_bytes stored;
+    if (ImGui::Button("Store##store-snapshot")) {
+        gold::save_snapshot(widgets, stored);
     }
-    if (ImGui::Selectable(name.data(), name == selected_component)) {
-        selected_component = name;
-        return component{};
+    if (not stored.empty()) {
+        ImGui::SameLine();
+        if (ImGui::Button("Swap##swap-snapshot")) {
+            gold::snapshot_bytes current;
+            gold::save_snapshot(widgets, current);
+            gold::load_snapshot(stored, widgets);
+            stored.swap(current);
+            // the selected widget may not be in the restored snapshot
+            if (not widgets.valid(editor.selected_widget)) {
+                editor.selected_widget = entt::null;
+                widgets.each([&editor](entt::entity widget) {
+                    if (editor.selected_widget == entt::null) {
+                        editor.selected_widget = widget;
+                    }
+                });
+            }
+        }
     }
-    return std::nullopt;
+    ImGui::Unindent();
 }
 void ShowAddComponentOption(entt::registry & widgets, entt::entity widget)
 {
     ImGui::Text("Add Component");
     ImGui::Spacing();
     ImGui::Indent();
-    static std::variant<std::monostate, gold::layout,
-        gold::size, gold::background_color>
-        new_component;
+    static gold::widget_components::variant new_component;
     static std::string_view selected_component;
     if (ImGui::BeginCombo("##Select Component", selected_component.data())) {
-        if (auto const layout = ComboOption<gold::layout>(
-            widgets, widget, selected_component))
-        {
-            new_component = *layout;
-        }
-        else if (auto const size = ComboOption<gold::size>(
-            widgets, widget, selected_component))
-        {
-            new_component = *size;
-        }
-        else if (auto const bg_color = ComboOption<gold::background_color>(
-            widgets, widget, selected_component))
-        {
-            new_component = *bg_color;
-        }
+        gold::widget_components::show_add_options(
+            widgets, widget, selected_component, new_component);
         ImGui::EndCombo();
     }
     ImGui::SameLine();
@@ -225,7 +246,7 @@ void ShowAddComponentOption(entt::registry & widgets, entt::entity widget)
 }
 void ShowEditorWindow(bool * is_open, gold::editor & editor)
 {
-    ImGui::WindowView window_params;
+    ImGui::LabelWindowView window_params;
     window_params.id = "Widget Editor";
     window_params.is_open = is_open;
     window_params.position = { 500.f, 50.f };
@@ -236,46 +257,92 @@ void ShowEditorWindow(bool * is_open, gold::editor & editor)
         return;
     }
     ShowSaveOption(editor.widgets, editor.selected_widget);
+    ShowSnapshotOption(editor);
     ShowAddComponentOption(editor.widgets, editor.selected_widget);
 
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Spacing();
 
-    gold::show_component_options<gold::layout>(
-        editor.widgets, editor.selected_widget);
-    gold::show_component_options<gold::size>(
-        editor.widgets, editor.selected_widget);
-    gold::show_component_options<gold::background_color>(
-        editor.widgets, editor.selected_widget);
+    gold::widget_components::show_options(editor.widgets,
+                                          editor.selected_widget);
+    gold::compact_widget_components::show_options(editor.widgets,
+                                                  editor.selected_widget);
 
     ImGui::End();
 }
 }
 
-void render_demo(SDL_Window *)
+namespace global {
+gold::editor editor;
+ion::frame_statistics * statistics = nullptr;
+}
+
+gold::editor load_editor()
+{
+    ion::stopwatch const load_time{ [](auto elapsed) {
+        using milliseconds = std::chrono::duration<double, std::milli>;
+        std::cout << "loaded widgets in "
+                  << milliseconds{ elapsed }.count() << "ms\n";
+    } };
+    gold::editor editor;
+    // the errors of one load all live in one arena, released together
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::vector<YAML::Exception> errors{ &arena };
+    auto const config = YAML::LoadFile(paths::widget_config.string());
+    editor.selected_widget = konbu::read_widget(
+        config, editor.widgets, errors);
+    return editor;
+}
+
+void print_startup(ion::startup_timings const & startup)
+{
+    using milliseconds = std::chrono::duration<double, std::milli>;
+    std::cout << "first frame after "
+              << milliseconds{ startup.first_frame }.count() << "ms (init "
+              << milliseconds{ startup.initialized }.count() << "ms, fonts "
+              << milliseconds{ startup.fonts }.count() << "ms"
+              << (startup.fonts_cached ? " from cache" : "") << ")\n";
+}
+
+void ShowStatisticsWindow(bool * is_open, ion::frame_statistics const & stats)
 {
-    static gold::editor editor;
-    static bool has_init = false;
-    if (not has_init) {
-        std::vector<YAML::Exception> errors;
-        auto const config = YAML::LoadFile(paths::widget_config.string());
-        editor.selected_widget = konbu::read_widget(
-            config, editor.widgets, errors);
-        has_init = true;
+    ImGui::LabelWindowView window_params;
+    window_params.id = "Frame Times (ms)";
+    window_params.is_open = is_open;
+    window_params.position.y += 400.f;
+
+    if (not ImGui::NewWindow(window_params)) {
+        ImGui::End();
+        return;
     }
+    if (ImGui::BeginQuantileTable("Frame Times")) {
+        ImGui::QuantileRow("frame", stats.frame.snapshot());
+        ImGui::QuantileRow("update", stats.update.snapshot());
+        ImGui::QuantileRow("render", stats.render.snapshot());
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void render_demo(SDL_Window *)
+{
+    auto & editor = global::editor;
     if (global::show_demo) {
         ImGui::ShowDemoWindow(&global::show_demo);
     }
     if (global::show_editor) {
         ImGui::ShowEditorWindow(&global::show_editor, editor);
     }
+    if (global::show_statistics and global::statistics) {
+        ShowStatisticsWindow(&global::show_statistics, *global::statistics);
+    }
     if (not ImGui::NewWindow()) {
         ImGui::End();
         return;
     }
     // draw example widget centered
-    editor.widgets.each([](auto widget) {
+    editor.widgets.each([&editor](auto widget) {
         gold::render(editor.widgets, widget);
     });
     ImGui::End();
@@ -317,8 +384,22 @@ void toggle_editor(SDL_Keysym const & sym)
     }
 }
 
+void toggle_statistics(SDL_Keysym const & sym)
+{
+    auto constexpr statistics_mask = KMOD_CTRL;
+    bool const can_toggle = mask_contains<statistics_mask>(sym.mod) and
+                            has_mask<KMOD_CTRL>(sym.mod);
+
+    if (sym.sym == SDLK_t and can_toggle) {
+        global::show_statistics = not global::show_statistics;
+    }
+}
+
 int main()
 {
+    // parse the widgets while the window and OpenGL context come up
+    auto editor = std::async(std::launch::async, load_editor);
+
     std::vector<YAML::Exception> yaml_errors;
     auto system = ion::system::from_config(paths::system_config, yaml_errors);
 
@@ -329,9 +410,15 @@ int main()
         return EXIT_FAILURE;
     }
 
+    global::editor = editor.get();
+    system->add_subsystem<ion::jobs>();
+    global::statistics = &system->add_subsystem<ion::frame_statistics>();
+
     system->on_render().connect<&render_demo>();
+    system->on_first_frame().connect<&print_startup>();
     system->on_keydown().connect<&toggle_demo>();
     system->on_keydown().connect<&toggle_editor>();
-    system->start();
+    system->on_keydown().connect<&toggle_statistics>();
+    ion::run(*system);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -21,6 +21,7 @@ constexpr float sq_dist(gold::background_color const & lhs,
 template<>
 struct component_info<gold::background_color> {
     static constexpr std::string_view public_name = "Background Color";
+    static constexpr std::string_view key = "bg-color";
 };
 }
 namespace konbu {
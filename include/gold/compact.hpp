@@ -0,0 +1,125 @@
+#pragma once
+#include "gold/component.hpp"
+#include "gold/layout.hpp"
+#include "gold/size.hpp"
+#include "gold/background_color.hpp"
+#include "imgui/imgui.h"
+
+#include <entt/entity/registry.hpp>
+#include <yaml-cpp/yaml.h>
+#include <array>
+#include <cstdint>
+#include <ranges>
+
+//
+// Compact components trade precision for memory bandwidth. They're converted
+// from and to the regular components when widgets are loaded and saved, and
+// are read directly when rendering.
+//
+inline namespace gold {
+
+/** A background color packed as 8-bit RGBA, in the same layout as IM_COL32 */
+struct compact_background_color {
+    // the same as the default background_color
+    ImU32 rgba = IM_COL32(41, 166, 255, 128);
+};
+
+/** Both alignment settings packed into one byte */
+struct compact_layout {
+    // horizontal alignment in the low nibble, vertical in the high nibble
+    std::uint8_t alignment = 0u;
+
+    [[nodiscard]] constexpr align::horizontal horizontal() const;
+    [[nodiscard]] constexpr align::vertical vertical() const;
+    bool constexpr operator==(compact_layout const & rhs) const = default;
+};
+
+/** A widget size stored as two half-precision floats */
+struct compact_size {
+    // the same as the default size
+    std::uint16_t width = 0x5a40u;  // 200
+    std::uint16_t height = 0x5100u; // 40
+};
+
+static_assert(sizeof(compact_background_color) == 4);
+static_assert(sizeof(compact_layout) == 1);
+static_assert(sizeof(compact_size) == 4);
+
+[[nodiscard]] constexpr std::uint16_t to_half(float value);
+[[nodiscard]] constexpr float from_half(std::uint16_t bits);
+
+[[nodiscard]] constexpr gold::compact_background_color
+compact(gold::background_color const & color);
+[[nodiscard]] constexpr gold::background_color
+expand(gold::compact_background_color color);
+
+[[nodiscard]] constexpr gold::compact_layout compact(gold::layout layout);
+[[nodiscard]] constexpr gold::layout expand(gold::compact_layout layout);
+
+[[nodiscard]] constexpr gold::compact_size compact(gold::size const & size);
+[[nodiscard]] constexpr gold::size expand(gold::compact_size size);
+
+/** Replace the regular components of every widget with compact ones. */
+void compact(entt::registry & widgets);
+
+/** Replace the compact components of every widget with regular ones. */
+void expand(entt::registry & widgets);
+
+template<>
+struct component_info<gold::compact_background_color> {
+    static constexpr std::string_view public_name = "Background Color";
+    static constexpr std::string_view key = "bg-color";
+};
+template<>
+struct component_info<gold::compact_layout> {
+    static constexpr std::string_view public_name = "Alignment";
+    static constexpr std::string_view key = "align";
+    static constexpr std::array<std::string_view, 2> aliases{
+        "layout", "alignment"
+    };
+};
+template<>
+struct component_info<gold::compact_size> {
+    static constexpr std::string_view public_name = "Size";
+    static constexpr std::string_view key = "size";
+};
+}
+
+namespace konbu {
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config, gold::compact_background_color & color,
+                                     error_output & errors);
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config, gold::compact_layout & layout,
+                                     error_output & errors);
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config, gold::compact_size & size,
+                                     error_output & errors);
+}
+
+namespace YAML {
+template<>
+struct convert<gold::compact_background_color> {
+    static Node encode(gold::compact_background_color color);
+};
+template<>
+struct convert<gold::compact_layout> {
+    static Node encode(gold::compact_layout layout);
+};
+template<>
+struct convert<gold::compact_size> {
+    static Node encode(gold::compact_size size);
+};
+}
+
+#include "gold/component_set.hpp"
+inline namespace gold {
+/** Widget components read and written in their compact form. */
+using compact_widget_components =
+    gold::component_set<gold::compact_layout,
+                        gold::compact_size,
+                        gold::compact_background_color>;
+}
+#include "gold/impl/compact.tcc"
@@ -1,6 +1,7 @@
 #pragma once
 #include <string_view>
 #include <concepts>
+#include <ranges>
 #include <entt/entity/registry.hpp>
 
 inline namespace gold {
@@ -14,6 +15,24 @@ constexpr bool has_public_name = requires() {
         -> std::convertible_to<std::string_view>;
 };
 
+/** The component can be read from and written to a yaml widget key. */
+template<typename component>
+constexpr bool has_yaml_key = requires() {
+    { component_info<component>::key }
+        -> std::convertible_to<std::string_view>;
+};
+
+/**
+ * \brief The component can also be read from alternative yaml keys
+ *
+ * Aliases are tried in order before `key`, which is the key that's written.
+ */
+template<typename component>
+constexpr bool has_yaml_aliases = requires() {
+    { *std::ranges::begin(component_info<component>::aliases) }
+        -> std::convertible_to<std::string_view>;
+};
+
 template<typename component>
 concept editor_option = requires(component & v) {
     show_options(v);
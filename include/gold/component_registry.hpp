@@ -0,0 +1,156 @@
+#pragma once
+#include "gold/component.hpp"
+
+#include <entt/entity/registry.hpp>
+#include <yaml-cpp/yaml.h>
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ranges>
+
+inline namespace gold {
+
+/**
+ * \brief Read a component from yaml and add it to a widget
+ *
+ * Errors are a std::pmr::vector, so that type-erased readers still allocate
+ * from the memory resource of the caller's error list.
+ */
+using component_reader = void (*)(YAML::Node const & config,
+                                  entt::registry & widgets,
+                                  entt::entity widget,
+                                  std::pmr::vector<YAML::Exception> & errors);
+
+/** Write a widget's component as a yaml value, if the widget has it. */
+using component_writer = void (*)(YAML::Emitter & out,
+                                  entt::registry const & widgets,
+                                  entt::entity widget);
+
+/** Show the editor options of a widget's component. */
+using component_editor = void (*)(entt::registry & widgets,
+                                  entt::entity widget);
+
+/**
+ * \brief Metadata and type-erased functions of a widget component type
+ *
+ * Entries without a reader or writer are registered, but skipped when
+ * reading or writing widgets.
+ */
+struct component_entry {
+    entt::id_type id;
+    std::string public_name;
+    std::vector<std::string> keys; // read keys, in order of precedence
+
+    component_reader reader = nullptr;
+    component_writer writer = nullptr;
+    component_editor editor = nullptr;
+    std::size_t size = 0;
+};
+
+/**
+ * \brief Component types known at runtime, such as those loaded from plugins
+ *
+ * Entries are stored contiguously and addressed by a dense index. Type ids
+ * and yaml keys find their dense index in flat tables, probed linearly from
+ * their hash. A yaml key that's already registered keeps its first entry.
+ */
+class component_registry {
+public:
+    /** Register a component type from its component_info. */
+    template<typename component>
+    requires gold::has_yaml_key<component>
+    std::size_t add();
+
+    /** Register each component type from its component_info. */
+    template<typename... components>
+    requires (sizeof...(components) > 1)
+    void add();
+
+    /**
+     * \brief Register a type-erased component
+     * \return the dense index of the component, or of the entry that was
+     *         already registered with the same id
+     */
+    std::size_t add(gold::component_entry entry);
+
+    /** Find a component entry by its type id. */
+    [[nodiscard]] gold::component_entry const * find(entt::id_type id) const;
+
+    /** Find the component entry read from a yaml key. */
+    [[nodiscard]] gold::component_entry const *
+    find_key(std::string_view key) const;
+
+    /**
+     * \brief Read every registered component that's configured on a widget
+     *
+     * A component configured under several of its keys is read from the key
+     * of highest precedence, the same as with a component set.
+     *
+     * \tparam error_output allocator-aware container of yaml-exceptions
+     *
+     * \param config    YAML widget input
+     * \param widgets   the registry to add components to
+     * \param widget    the widget to add components to
+     * \param errors    write any parsing errors to
+     *
+     * The components' errors are gathered in the memory resource of `errors`
+     * when it has a polymorphic allocator, or the default resource otherwise.
+     */
+    template<std::ranges::output_range<YAML::Exception> error_output>
+    void read(YAML::Node const & config,
+              entt::registry & widgets, entt::entity widget,
+              error_output & errors) const;
+
+    /** Write every registered component that a widget has. */
+    void write(YAML::Emitter & out,
+               entt::registry const & widgets, entt::entity widget) const;
+
+    /** Show the options panel of every editable component a widget has. */
+    void show_options(entt::registry & widgets, entt::entity widget) const;
+
+    [[nodiscard]] inline std::size_t size() const { return entries.size(); }
+    [[nodiscard]] inline auto begin() const { return entries.begin(); }
+    [[nodiscard]] inline auto end() const { return entries.end(); }
+private:
+    void read_entries(YAML::Node const & config,
+                      entt::registry & widgets, entt::entity widget,
+                      std::pmr::vector<YAML::Exception> & errors) const;
+
+    static constexpr std::size_t no_entry = static_cast<std::size_t>(-1);
+
+    // a yaml key, the dense index of its entry and its rank among the keys
+    // of the entry, an empty slot has no entry
+    struct key_slot {
+        std::string key;
+        std::size_t entry = no_entry;
+        std::size_t rank = 0u;
+    };
+
+    // returns the slot of the id or key, or the empty slot where it belongs
+    [[nodiscard]] std::size_t find_id_slot(entt::id_type id) const;
+    [[nodiscard]] std::size_t find_key_slot(std::string_view key) const;
+    [[nodiscard]] key_slot const * find_key_entry(std::string_view key) const;
+    void rehash(std::size_t capacity);
+
+    std::vector<gold::component_entry> entries;
+    // both tables have the same power of two size, and are at most 3/4 full
+    std::vector<std::size_t> id_slots;
+    std::vector<key_slot> key_slots;
+    std::size_t key_count = 0u;
+    // turns a hash into a slot index, by keeping its top bits
+    unsigned shift = 64u;
+};
+}
+
+namespace konbu {
+/** Read a widget made of any components known to a component registry. */
+template<std::ranges::output_range<YAML::Exception> error_output>
+entt::entity read_widget(YAML::Node const & config,
+                         entt::registry & widgets,
+                         gold::component_registry const & components,
+                         error_output & errors);
+}
+#include "gold/impl/component_registry.tcc"
@@ -0,0 +1,89 @@
+#pragma once
+#include "gold/component.hpp"
+#include "konbu/konbu.h"
+
+#include <entt/entity/registry.hpp>
+#include <yaml-cpp/yaml.h>
+
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <ranges>
+
+inline namespace gold {
+
+/**
+ * \brief A compile-time list of widget component types
+ * \tparam components   types with a yaml key in their component_info
+ *
+ * Reading, writing and editing a widget are generated from the component
+ * list, so adding a component type only means adding it to the set.
+ *
+ * \note konbu::read is looked up by its qualified name, so the read function
+ *       for each component must be declared before this header is included.
+ */
+template<typename... components>
+requires (gold::has_yaml_key<components> and ...)
+struct component_set {
+    /** Holds no component, or a value of any component in the set. */
+    using variant = std::variant<std::monostate, components...>;
+
+    /** The number of components in the set. */
+    static constexpr std::size_t size = sizeof...(components);
+
+    /**
+     * \brief Call a function template for each component, in order
+     * \param visit    called as visit.template operator()<component, index>()
+     */
+    template<typename visitor>
+    static void for_each(visitor && visit);
+
+    /**
+     * \brief Read every component of the set that's configured on a widget
+     * \tparam error_output allocator-aware container of yaml-exceptions
+     *
+     * \param config    YAML widget input
+     * \param widgets   the registry to add components to
+     * \param widget    the widget to add components to
+     * \param errors    write any parsing errors to
+     */
+    template<std::ranges::output_range<YAML::Exception> error_output>
+    static void read(YAML::Node const & config,
+                     entt::registry & widgets, entt::entity widget,
+                     error_output & errors);
+
+    /** Write every component of the set that a widget has. */
+    static void write(YAML::Emitter & out,
+                      entt::registry const & widgets, entt::entity widget);
+
+    /**
+     * \brief Archive every component of the set
+     * \param snapshot  an entt::snapshot or entt::snapshot_loader
+     * \param archive   the archive to read or write with
+     */
+    template<typename snapshot_type, typename archive_type>
+    static void archive(snapshot_type const & snapshot, archive_type & archive);
+
+    /**
+     * \brief Show a selectable for every component a widget doesn't have
+     *
+     * \param widgets               the registry the widget lives in
+     * \param widget                the widget to show options for
+     * \param selected_component    the public name of the selected component
+     * \param new_component         set to the default value of the selected
+     *                              component
+     */
+    static void show_add_options(entt::registry const & widgets,
+                                 entt::entity widget,
+                                 std::string_view & selected_component,
+                                 variant & new_component)
+    requires (gold::has_public_name<components> and ...);
+
+    /** Show the options panel of every component a widget has. */
+    static void show_options(entt::registry & widgets, entt::entity widget)
+    requires (gold::editor_option<components> and ...)
+         and (gold::has_public_name<components> and ...);
+};
+}
+#include "gold/impl/component_set.tcc"
@@ -0,0 +1,167 @@
+#include "konbu/konbu.h"
+#include <bit>
+#include <cmath>
+
+constexpr gold::align::horizontal gold::compact_layout::horizontal() const
+{
+    return static_cast<align::horizontal>(alignment & 0x0fu);
+}
+constexpr gold::align::vertical gold::compact_layout::vertical() const
+{
+    return static_cast<align::vertical>(alignment >> 4u);
+}
+
+constexpr std::uint16_t gold::to_half(float value)
+{
+    auto const bits = std::bit_cast<std::uint32_t>(value);
+    auto const sign = static_cast<std::uint16_t>((bits >> 16u) & 0x8000u);
+    std::uint32_t const float_exponent = (bits >> 23u) & 0xffu;
+    std::uint32_t mantissa = bits & 0x7fffffu;
+
+    // infinity and nan keep their meaning
+    if (float_exponent == 0xffu) {
+        return sign | 0x7c00u | (mantissa != 0u ? 0x200u : 0u);
+    }
+    auto const exponent = static_cast<std::int32_t>(float_exponent) - 112;
+    if (exponent >= 0x1f) {
+        return sign | 0x7c00u;
+    }
+    // too small for a normal half, so shift into a subnormal half
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000u;
+        auto const shift = static_cast<std::uint32_t>(14 - exponent);
+        auto const half = static_cast<std::uint16_t>(mantissa >> shift);
+        auto const round = (mantissa >> (shift - 1u)) & 1u;
+        return static_cast<std::uint16_t>(sign | (half + round));
+    }
+    // rounding may carry into the exponent, which is still correct
+    auto const half = static_cast<std::uint32_t>(exponent) << 10u
+                    | (mantissa >> 13u);
+    auto const round = (mantissa >> 12u) & 1u;
+    return static_cast<std::uint16_t>(sign | (half + round));
+}
+
+constexpr float gold::from_half(std::uint16_t bits)
+{
+    std::uint32_t const sign = static_cast<std::uint32_t>(bits & 0x8000u) << 16u;
+    std::uint32_t const exponent = (bits >> 10u) & 0x1fu;
+    std::uint32_t const mantissa = bits & 0x3ffu;
+
+    if (exponent == 0u) {
+        float const value = static_cast<float>(mantissa) / 16777216.f;
+        return sign != 0u ? -value : value;
+    }
+    if (exponent == 0x1fu) {
+        return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13u));
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112u) << 23u)
+                                     | (mantissa << 13u));
+}
+
+namespace gold::detail {
+constexpr ImU32 to_channel(float value)
+{
+    float const clamped = value < 0.f ? 0.f : value > 1.f ? 1.f : value;
+    return static_cast<ImU32>(clamped * 255.f + .5f);
+}
+constexpr float from_channel(ImU32 rgba, unsigned shift)
+{
+    return static_cast<float>((rgba >> shift) & 0xffu) / 255.f;
+}
+}
+
+constexpr gold::compact_background_color
+gold::compact(gold::background_color const & color)
+{
+    return compact_background_color{
+        IM_COL32(detail::to_channel(color.red),
+                 detail::to_channel(color.green),
+                 detail::to_channel(color.blue),
+                 detail::to_channel(color.alpha))
+    };
+}
+constexpr gold::background_color
+gold::expand(gold::compact_background_color color)
+{
+    return background_color{
+        detail::from_channel(color.rgba, IM_COL32_R_SHIFT),
+        detail::from_channel(color.rgba, IM_COL32_G_SHIFT),
+        detail::from_channel(color.rgba, IM_COL32_B_SHIFT),
+        detail::from_channel(color.rgba, IM_COL32_A_SHIFT)
+    };
+}
+
+constexpr gold::compact_layout gold::compact(gold::layout layout)
+{
+    auto const horizontal = static_cast<unsigned>(layout.horizontal);
+    auto const vertical = static_cast<unsigned>(layout.vertical);
+    return compact_layout{
+        static_cast<std::uint8_t>(horizontal | (vertical << 4u))
+    };
+}
+constexpr gold::layout gold::expand(gold::compact_layout layout)
+{
+    return gold::layout{ layout.horizontal(), layout.vertical() };
+}
+
+constexpr gold::compact_size gold::compact(gold::size const & size)
+{
+    return compact_size{ to_half(size.width), to_half(size.height) };
+}
+constexpr gold::size gold::expand(gold::compact_size size)
+{
+    return gold::size{ from_half(size.width), from_half(size.height) };
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline void
+konbu::read(YAML::Node const & config,
+            gold::compact_background_color & color,
+            error_output & errors)
+{
+    auto full_color = gold::expand(color);
+    konbu::read(config, full_color, errors);
+    color = gold::compact(full_color);
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline void
+konbu::read(YAML::Node const & config,
+            gold::compact_layout & layout,
+            error_output & errors)
+{
+    auto full_layout = gold::expand(layout);
+    konbu::read(config, full_layout, errors);
+    layout = gold::compact(full_layout);
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline void
+konbu::read(YAML::Node const & config,
+            gold::compact_size & size,
+            error_output & errors)
+{
+    auto full_size = gold::expand(size);
+    konbu::read(config, full_size, errors);
+    size = gold::compact(full_size);
+}
+
+inline YAML::Node
+YAML::convert<gold::compact_background_color>::encode(
+    gold::compact_background_color color)
+{
+    return YAML::Node{ gold::expand(color) };
+}
+inline YAML::Node
+YAML::convert<gold::compact_layout>::encode(gold::compact_layout layout)
+{
+    return YAML::Node{ gold::expand(layout) };
+}
+inline YAML::Node
+YAML::convert<gold::compact_size>::encode(gold::compact_size size)
+{
+    return YAML::Node{ gold::expand(size) };
+}
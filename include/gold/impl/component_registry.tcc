@@ -0,0 +1,73 @@
+#include "gold/component_set.hpp"
+#include <entt/core/type_info.hpp>
+
+namespace gold::detail {
+
+template<typename component>
+void read_erased(YAML::Node const & config,
+                 entt::registry & widgets, entt::entity widget,
+                 std::pmr::vector<YAML::Exception> & errors)
+{
+    component value;
+    konbu::read(config, value, errors);
+    widgets.emplace<component>(widget, value);
+}
+}
+
+template<typename component>
+requires gold::has_yaml_key<component>
+inline std::size_t gold::component_registry::add()
+{
+    using info = component_info<component>;
+    gold::component_entry entry;
+    entry.id = entt::type_hash<component>::value();
+    entry.reader = &detail::read_erased<component>;
+    entry.writer = &detail::write_component<component>;
+    entry.size = sizeof(component);
+    if constexpr (gold::has_public_name<component>) {
+        entry.public_name = info::public_name;
+    }
+    if constexpr (gold::has_yaml_aliases<component>) {
+        for (std::string_view const alias : info::aliases) {
+            entry.keys.emplace_back(alias);
+        }
+    }
+    entry.keys.emplace_back(info::key);
+    if constexpr (gold::editor_option<component> and
+                  gold::has_public_name<component>) {
+        entry.editor = &gold::show_component_options<component>;
+    }
+    return add(std::move(entry));
+}
+
+template<typename... components>
+requires (sizeof...(components) > 1)
+inline void gold::component_registry::add()
+{
+    (add<components>(), ...);
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline void
+gold::component_registry::read(YAML::Node const & config,
+                               entt::registry & widgets, entt::entity widget,
+                               error_output & errors) const
+{
+    std::pmr::vector<YAML::Exception> component_errors{
+        konbu::memory_resource_of(errors) };
+    read_entries(config, widgets, widget, component_errors);
+    std::ranges::copy(component_errors,
+                      konbu::back_inserter_preference(errors));
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline entt::entity
+konbu::read_widget(YAML::Node const & config,
+                   entt::registry & widgets,
+                   gold::component_registry const & components,
+                   error_output & errors)
+{
+    auto const widget = widgets.create();
+    components.read(config, widgets, widget, errors);
+    return widget;
+}
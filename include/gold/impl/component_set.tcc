@@ -0,0 +1,130 @@
+#include "imgui/imgui.h"
+#include <string>
+
+namespace gold::detail {
+
+template<typename component>
+requires gold::has_yaml_key<component>
+YAML::Node find_config(YAML::Node const & config)
+{
+    using info = component_info<component>;
+    if constexpr (gold::has_yaml_aliases<component>) {
+        for (std::string_view const alias : info::aliases) {
+            if (auto const alias_config = config[std::string{ alias }]) {
+                return alias_config;
+            }
+        }
+    }
+    if (auto const component_config = config[std::string{ info::key }]) {
+        return component_config;
+    }
+    return YAML::Node{ YAML::NodeType::Undefined };
+}
+
+template<typename component,
+         std::ranges::output_range<YAML::Exception> error_output>
+void read_component(YAML::Node const & config,
+                    entt::registry & widgets, entt::entity widget,
+                    error_output & errors)
+{
+    if (auto const component_config = find_config<component>(config)) {
+        component value;
+        konbu::read(component_config, value, errors);
+        widgets.emplace<component>(widget, value);
+    }
+}
+
+template<typename component>
+void write_component(YAML::Emitter & out,
+                     entt::registry const & widgets, entt::entity widget)
+{
+    if (auto const * value = widgets.try_get<component>(widget)) {
+        std::string_view constexpr key = component_info<component>::key;
+        out << YAML::Key << std::string{ key }
+            << YAML::Value << YAML::Flow << YAML::Node{ *value };
+    }
+}
+
+template<typename component, typename variant>
+requires gold::has_public_name<component>
+void show_add_option(entt::registry const & widgets, entt::entity widget,
+                     std::string_view & selected_component,
+                     variant & new_component)
+{
+    std::string_view constexpr name = component_info<component>::public_name;
+    if (widgets.any_of<component>(widget)) {
+        return;
+    }
+    if (ImGui::Selectable(name.data(), name == selected_component)) {
+        selected_component = name;
+        new_component = component{};
+    }
+}
+}
+
+template<typename... components>
+requires (gold::has_yaml_key<components> and ...)
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline void
+gold::component_set<components...>::read(YAML::Node const & config,
+                                         entt::registry & widgets,
+                                         entt::entity widget,
+                                         error_output & errors)
+{
+    (detail::read_component<components>(config, widgets, widget, errors), ...);
+}
+
+template<typename... components>
+requires (gold::has_yaml_key<components> and ...)
+template<typename visitor>
+inline void
+gold::component_set<components...>::for_each(visitor && visit)
+{
+    [&visit]<std::size_t... indices>(std::index_sequence<indices...>) {
+        (visit.template operator()<components, indices>(), ...);
+    }(std::index_sequence_for<components...>{});
+}
+
+template<typename... components>
+requires (gold::has_yaml_key<components> and ...)
+inline void
+gold::component_set<components...>::write(YAML::Emitter & out,
+                                          entt::registry const & widgets,
+                                          entt::entity widget)
+{
+    (detail::write_component<components>(out, widgets, widget), ...);
+}
+
+template<typename... components>
+requires (gold::has_yaml_key<components> and ...)
+template<typename snapshot_type, typename archive_type>
+inline void
+gold::component_set<components...>::archive(snapshot_type const & snapshot,
+                                            archive_type & archive)
+{
+    snapshot.template component<components...>(archive);
+}
+
+template<typename... components>
+requires (gold::has_yaml_key<components> and ...)
+inline void
+gold::component_set<components...>::show_add_options(
+    entt::registry const & widgets, entt::entity widget,
+    std::string_view & selected_component, variant & new_component)
+requires (gold::has_public_name<components> and ...)
+{
+    (detail::show_add_option<components>(widgets, widget,
+                                         selected_component, new_component),
+     ...);
+}
+
+template<typename... components>
+requires (gold::has_yaml_key<components> and ...)
+inline void
+gold::component_set<components...>::show_options(entt::registry & widgets,
+                                                 entt::entity widget)
+requires (gold::editor_option<components> and ...)
+     and (gold::has_public_name<components> and ...)
+{
+    (gold::show_component_options<components>(widgets, widget), ...);
+}
@@ -54,7 +54,8 @@ inline void konbu::read(YAML::Node const & config,
     YAML::Node vertical_config;
 
     if (config.IsScalar()) {
-        std::unordered_set<std::string> const valid_names{ "center", "fill" };
+        static std::unordered_set<std::string> const valid_names{ "center",
+                                                                  "fill" };
         if (valid_names.find(config.Scalar()) != valid_names.end()) {
             horizontal_config = config;
             vertical_config = config;
@@ -83,7 +84,7 @@ inline void konbu::read(YAML::Node const & config,
         vertical_config = config["vertical"];
     }
     if (horizontal_config) {
-        std::vector<YAML::Exception> horizontal_errors;
+        auto horizontal_errors = konbu::error_buffer_for(errors);
         konbu::read(horizontal_config, layout.horizontal, horizontal_errors);
         ranges::transform(horizontal_errors,
                           konbu::back_inserter_preference(errors),
@@ -91,7 +92,7 @@ inline void konbu::read(YAML::Node const & config,
                                                      layout.horizontal));
     }
     if (vertical_config) {
-        std::vector<YAML::Exception> vertical_errors;
+        auto vertical_errors = konbu::error_buffer_for(errors);
         konbu::read(vertical_config, layout.vertical, vertical_errors);
         ranges::transform(vertical_errors,
                           konbu::back_inserter_preference(errors),
@@ -0,0 +1,33 @@
+template<typename component>
+requires std::is_trivially_copyable_v<component>
+inline void
+gold::binary_output_archive::operator()(entt::entity entity,
+                                        component const & value)
+{
+    write(&entity, sizeof(entity));
+    write(&value, sizeof(component));
+}
+
+template<typename component>
+requires std::is_trivially_copyable_v<component>
+inline void
+gold::binary_input_archive::operator()(entt::entity & entity,
+                                       component & value)
+{
+    read(&entity, sizeof(entity));
+    read(&value, sizeof(component));
+}
+
+template<typename value_type>
+requires std::is_trivially_copyable_v<value_type>
+inline void gold::binary_output_archive::value(value_type const & value)
+{
+    write(&value, sizeof(value_type));
+}
+
+template<typename value_type>
+requires std::is_trivially_copyable_v<value_type>
+inline void gold::binary_input_archive::value(value_type & value)
+{
+    read(&value, sizeof(value_type));
+}
@@ -0,0 +1,141 @@
+template<gold::style_value component>
+inline gold::style_handle
+gold::style_pool<component>::intern(component const & value)
+{
+    std::size_t const key = gold::style_key(value);
+    auto const [first, last] = buckets.equal_range(key);
+    for (auto it = first; it != last; ++it) {
+        auto & record = records[it->second];
+        if (gold::sq_dist(record.value, value) < epsilon) {
+            ++record.uses;
+            return it->second;
+        }
+    }
+    gold::style_handle handle;
+    if (free_handles.empty()) {
+        handle = static_cast<gold::style_handle>(records.size());
+        records.push_back(record{ value, 1u });
+    }
+    else {
+        handle = free_handles.back();
+        free_handles.pop_back();
+        records[handle] = record{ value, 1u };
+    }
+    buckets.emplace(key, handle);
+    return handle;
+}
+
+template<gold::style_value component>
+inline void gold::style_pool<component>::release(gold::style_handle handle)
+{
+    auto & record = records[handle];
+    if (record.uses == 0u or --record.uses != 0u) {
+        return;
+    }
+    unlink(handle);
+    free_handles.push_back(handle);
+}
+
+template<gold::style_value component>
+inline void gold::style_pool<component>::set(gold::style_handle handle,
+                                             component const & value)
+{
+    // the handle stays valid, even if another style now has the same value
+    unlink(handle);
+    records[handle].value = value;
+    buckets.emplace(gold::style_key(value), handle);
+}
+
+template<gold::style_value component>
+inline void
+gold::style_pool<component>::assign(std::span<component const> values,
+                                    std::span<std::uint32_t const> uses)
+{
+    records.clear();
+    free_handles.clear();
+    buckets.clear();
+    for (std::size_t index = 0u; index < values.size(); ++index) {
+        auto const handle = static_cast<gold::style_handle>(index);
+        records.push_back(record{ values[index], uses[index] });
+        if (uses[index] == 0u) {
+            free_handles.push_back(handle);
+        }
+        else {
+            buckets.emplace(gold::style_key(values[index]), handle);
+        }
+    }
+}
+
+template<gold::style_value component>
+inline void gold::style_pool<component>::unlink(gold::style_handle handle)
+{
+    auto const [first, last] =
+        buckets.equal_range(gold::style_key(records[handle].value));
+    for (auto it = first; it != last; ++it) {
+        if (it->second == handle) {
+            buckets.erase(it);
+            return;
+        }
+    }
+}
+
+namespace gold::detail {
+template<gold::style_value component>
+void release_style(entt::registry & widgets, entt::entity widget)
+{
+    auto const & shared = widgets.get<gold::shared<component>>(widget);
+    widgets.ctx().get<gold::style_pool<component>>().release(shared.handle);
+}
+}
+
+template<gold::style_value component>
+inline gold::style_pool<component> & gold::styles(entt::registry & widgets)
+{
+    using pool = gold::style_pool<component>;
+    if (auto * styles = widgets.ctx().find<pool>()) {
+        return *styles;
+    }
+    widgets.on_destroy<gold::shared<component>>()
+           .template connect<&detail::release_style<component>>();
+    return widgets.ctx().emplace<pool>();
+}
+
+template<gold::style_value component>
+inline bool gold::share(entt::registry & widgets, entt::entity widget)
+{
+    auto const * value = widgets.try_get<component>(widget);
+    if (not value) {
+        return false;
+    }
+    auto const handle = gold::styles<component>(widgets).intern(*value);
+    // removing a shared component releases its style, replacing it wouldn't
+    widgets.remove<gold::shared<component>>(widget);
+    widgets.emplace<gold::shared<component>>(widget, handle);
+    widgets.erase<component>(widget);
+    return true;
+}
+
+template<gold::style_value component>
+inline void gold::share_all(entt::registry & widgets)
+{
+    auto const view = widgets.view<component>();
+    std::vector<entt::entity> const owners(view.begin(), view.end());
+    for (auto const widget : owners) {
+        gold::share<component>(widgets, widget);
+    }
+}
+
+template<gold::style_value component>
+inline component const *
+gold::try_get_style(entt::registry const & widgets, entt::entity widget)
+{
+    if (auto const * value = widgets.try_get<component>(widget)) {
+        return value;
+    }
+    auto const * shared = widgets.try_get<gold::shared<component>>(widget);
+    if (not shared) {
+        return nullptr;
+    }
+    auto const * styles = widgets.ctx().find<gold::style_pool<component>>();
+    return styles ? &styles->get(shared->handle) : nullptr;
+}
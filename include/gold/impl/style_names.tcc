@@ -0,0 +1,21 @@
+#include "konbu/konbu.h"
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline void konbu::read(YAML::Node const & config,
+                        gold::style_names & names,
+                        error_output & errors)
+{
+    namespace ranges = std::ranges;
+    namespace views = std::views;
+
+    std::string text;
+    konbu::read(config, text, errors);
+    auto parsed = gold::style_names::parse(text);
+    if (not parsed) {
+        YAML::Exception const error{ config.Mark(), parsed.error() };
+        ranges::copy(views::single(error),
+                     konbu::back_inserter_preference(errors));
+        return;
+    }
+    names = *std::move(parsed);
+}
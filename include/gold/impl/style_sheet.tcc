@@ -0,0 +1,72 @@
+#include "gold/widget.hpp"
+#include "konbu/konbu.h"
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline std::uint32_t
+gold::style_sheet::add_rule(gold::selector rule_selector,
+                            YAML::Node const & rule_declarations,
+                            error_output & errors)
+{
+    auto const index = static_cast<std::uint32_t>(rules.size());
+    auto const & key = rule_selector.parts.back();
+    if (not key.classes.empty()) {
+        by_class[key.classes.front()].push_back(index);
+    }
+    else if (not key.tag.empty() and key.tag != "*") {
+        by_tag[key.tag].push_back(index);
+    }
+    else {
+        universal.push_back(index);
+    }
+    auto const entity = declarations.create();
+    gold::widget_components::read(rule_declarations, declarations, entity,
+                                  errors);
+
+    structure_version = ++version;
+    auto const specificity = rule_selector.specificity();
+    rules.push_back(rule{ std::move(rule_selector), entity,
+                          specificity, version });
+    return index;
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline void
+gold::style_sheet::set_declarations(std::uint32_t index,
+                                    YAML::Node const & rule_declarations,
+                                    error_output & errors)
+{
+    auto & rule = rules[index];
+    declarations.destroy(rule.declarations);
+    rule.declarations = declarations.create();
+    gold::widget_components::read(rule_declarations, declarations,
+                                  rule.declarations, errors);
+    // only widgets the rule matched will be restyled
+    rule.version = ++version;
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline void konbu::read(YAML::Node const & config,
+                        gold::style_sheet & sheet,
+                        error_output & errors)
+{
+    namespace ranges = std::ranges;
+    namespace views = std::views;
+
+    if (not config.IsMap()) {
+        YAML::Exception const error{ config.Mark(), "expecting a map" };
+        ranges::copy(views::single(error),
+                     konbu::back_inserter_preference(errors));
+        return;
+    }
+    for (auto const & rule : config) {
+        auto parsed = gold::selector::parse(rule.first.Scalar());
+        if (not parsed) {
+            YAML::Exception const error{ rule.first.Mark(),
+                                         "invalid selector: " + parsed.error() };
+            ranges::copy(views::single(error),
+                         konbu::back_inserter_preference(errors));
+            continue;
+        }
+        sheet.add_rule(*std::move(parsed), rule.second, errors);
+    }
+}
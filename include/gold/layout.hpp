@@ -1,5 +1,6 @@
 #pragma once
 #include "gold/component.hpp"
+#include <array>
 #include <string>
 #include <ranges>
 #include <yaml-cpp/yaml.h>
@@ -37,6 +38,10 @@ template<>
 struct component_info<gold::layout> {
     using type = gold::layout;
     static constexpr std::string_view public_name = "Alignment";
+    static constexpr std::string_view key = "align";
+    static constexpr std::array<std::string_view, 2> aliases{
+        "layout", "alignment"
+    };
 };
 }
 
@@ -16,6 +16,7 @@ float sq_dist(gold::size const & lhs, gold::size const & rhs);
 template<>
 struct component_info<gold::size> {
     static constexpr std::string_view public_name = "Size";
+    static constexpr std::string_view key = "size";
 };
 }
 constexpr ImVec2 gold::size::vector() const
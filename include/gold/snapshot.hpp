@@ -0,0 +1,104 @@
+#pragma once
+#include <entt/entity/registry.hpp>
+#include <entt/entity/snapshot.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <type_traits>
+#include <vector>
+
+inline namespace gold {
+
+/** Raw bytes of a whole-registry widget snapshot. */
+using snapshot_bytes = std::vector<std::byte>;
+
+/**
+ * \brief An output archive for entt::snapshot that copies raw bytes
+ *
+ * Entities, counts and components are appended to the byte buffer as-is, so
+ * only trivially copyable components can be archived.
+ */
+class binary_output_archive {
+public:
+    explicit binary_output_archive(gold::snapshot_bytes & bytes);
+
+    void operator()(std::underlying_type_t<entt::entity> count);
+    void operator()(entt::entity entity);
+
+    template<typename component>
+    requires std::is_trivially_copyable_v<component>
+    void operator()(entt::entity entity, component const & value);
+
+    /** Append a value that isn't a component, such as a pooled style. */
+    template<typename value_type>
+    requires std::is_trivially_copyable_v<value_type>
+    void value(value_type const & value);
+private:
+    void write(void const * data, std::size_t size);
+    gold::snapshot_bytes * _bytes;
+};
+
+/**
+ * \brief An input archive for entt::snapshot_loader that copies raw bytes
+ *
+ * Reading past the end of the buffer leaves the value zeroed and marks the
+ * archive as failed.
+ */
+class binary_input_archive {
+public:
+    explicit binary_input_archive(gold::snapshot_bytes const & bytes,
+                                  std::size_t offset = 0);
+
+    void operator()(std::underlying_type_t<entt::entity> & count);
+    void operator()(entt::entity & entity);
+
+    template<typename component>
+    requires std::is_trivially_copyable_v<component>
+    void operator()(entt::entity & entity, component & value);
+
+    /** Read a value that isn't a component, such as a pooled style. */
+    template<typename value_type>
+    requires std::is_trivially_copyable_v<value_type>
+    void value(value_type & value);
+
+    /** Determine if every read so far was in bounds. */
+    [[nodiscard]] inline bool ok() const { return not _failed; }
+private:
+    void read(void * data, std::size_t size);
+    gold::snapshot_bytes const * _bytes;
+    std::size_t _offset;
+    bool _failed = false;
+};
+
+/**
+ * \brief Copy every widget, its gold components and shared styles into a
+ *        byte buffer
+ *
+ * \param widgets   the registry to snapshot
+ * \param bytes     overwritten with the snapshot data
+ *
+ * Components a style sheet applied aren't saved, since the style sheet
+ * applies them again when the widgets are restyled.
+ */
+void save_snapshot(entt::registry const & widgets, gold::snapshot_bytes & bytes);
+
+/**
+ * \brief Restore widgets from a byte buffer made by save_snapshot
+ *
+ * \param bytes     the snapshot data to restore
+ * \param widgets   cleared, then loaded with the snapshot widgets
+ *
+ * \return true if the snapshot was restored. Entity identifiers are the same
+ *         as when the snapshot was saved. Otherwise `widgets` is untouched.
+ */
+bool load_snapshot(gold::snapshot_bytes const & bytes, entt::registry & widgets);
+
+/** Save a whole-registry snapshot to a binary file. */
+bool save_snapshot(std::filesystem::path const & path,
+                   entt::registry const & widgets);
+
+/** Load a whole-registry snapshot from a binary file. */
+bool load_snapshot(std::filesystem::path const & path,
+                   entt::registry & widgets);
+}
+#include "gold/impl/snapshot.tcc"
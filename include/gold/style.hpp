@@ -0,0 +1,130 @@
+#pragma once
+#include "gold/size.hpp"
+#include "gold/background_color.hpp"
+
+#include <entt/entity/registry.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+inline namespace gold {
+
+/** Identifies an interned style value in a style_pool. */
+using style_handle = std::uint32_t;
+
+/**
+ * \brief A widget component that refers to a style value shared by others
+ * \tparam component the type of the shared value
+ */
+template<typename component>
+struct shared {
+    gold::style_handle handle;
+};
+
+/** Quantize a size to whole pixels. */
+std::size_t style_key(gold::size const & size);
+
+/** Quantize a color to 8-bit channels. */
+std::size_t style_key(gold::background_color const & color);
+
+/**
+ * \brief A value that can be interned in a style_pool
+ *
+ * Equal values must have the same style key. Values within the pool's epsilon
+ * of each other are merged when their style keys also match.
+ */
+template<typename component>
+concept style_value = std::copyable<component> and
+requires(component const & lhs, component const & rhs) {
+    { gold::sq_dist(lhs, rhs) } -> std::convertible_to<float>;
+    { gold::style_key(lhs) } -> std::convertible_to<std::size_t>;
+};
+
+/**
+ * \brief Deduplicated, reference-counted style values
+ * \tparam component the type of value to intern
+ *
+ * Widgets refer to pooled values through a gold::shared component, so setting
+ * a pooled value restyles every widget using it at once.
+ */
+template<gold::style_value component>
+class style_pool {
+public:
+    /** The squared distance under which two values are the same style. */
+    static constexpr float epsilon = 1e-4f;
+
+    /** Find an equivalent value, or add a new one, and add one use to it. */
+    gold::style_handle intern(component const & value);
+
+    /** Remove one use from a style, freeing it when it has no more uses. */
+    void release(gold::style_handle handle);
+
+    /** Replace the value of a style for every widget that uses it. */
+    void set(gold::style_handle handle, component const & value);
+
+    /**
+     * \brief Replace every style, such as with the styles of a saved pool
+     * \param values    the value of each handle
+     * \param uses      the use count of each handle, 0 if it's free
+     */
+    void assign(std::span<component const> values,
+                std::span<std::uint32_t const> uses);
+
+    [[nodiscard]] inline component const & get(gold::style_handle handle) const
+    {
+        return records[handle].value;
+    }
+    [[nodiscard]] inline std::uint32_t
+    use_count(gold::style_handle handle) const
+    {
+        return records[handle].uses;
+    }
+    /** The number of handles given out so far, in use or free. */
+    [[nodiscard]] inline std::size_t handle_count() const
+    {
+        return records.size();
+    }
+    /** The number of distinct styles in use. */
+    [[nodiscard]] inline std::size_t size() const
+    {
+        return records.size() - free_handles.size();
+    }
+private:
+    struct record {
+        component value;
+        std::uint32_t uses = 0u;
+    };
+    void unlink(gold::style_handle handle);
+
+    std::vector<record> records;
+    std::vector<gold::style_handle> free_handles;
+    std::unordered_multimap<std::size_t, gold::style_handle> buckets;
+};
+
+/**
+ * \brief Get the style pool of a registry, creating it on first use
+ *
+ * Destroying a gold::shared component releases its use of the style.
+ */
+template<gold::style_value component>
+gold::style_pool<component> & styles(entt::registry & widgets);
+
+/**
+ * \brief Replace a widget's own component with a shared one
+ * \return true if the widget had the component to share
+ */
+template<gold::style_value component>
+bool share(entt::registry & widgets, entt::entity widget);
+
+/** Share the component of every widget that has its own. */
+template<gold::style_value component>
+void share_all(entt::registry & widgets);
+
+/** Get a widget's own or shared component value, if it has either. */
+template<gold::style_value component>
+[[nodiscard]] component const *
+try_get_style(entt::registry const & widgets, entt::entity widget);
+}
+#include "gold/impl/style.tcc"
@@ -0,0 +1,59 @@
+#pragma once
+#include "gold/component.hpp"
+
+#include <entt/entity/registry.hpp>
+#include <yaml-cpp/yaml.h>
+
+#include <expected>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+inline namespace gold {
+
+/**
+ * \brief The names a style sheet selects a widget by
+ *
+ * In yaml, the names are written like a css compound selector, for example
+ * `style: button.primary.large`.
+ */
+struct style_names {
+    std::string tag;
+    std::vector<std::string> classes;
+
+    /** Parse names of the form `tag.class.class`. */
+    [[nodiscard]] static std::expected<gold::style_names, std::string>
+    parse(std::string_view text);
+
+    [[nodiscard]] bool has_class(std::string_view name) const;
+};
+
+/**
+ * \brief The widget a widget is nested in, for hierarchical selectors
+ *
+ * Widgets are read from yaml one at a time, so parents are set in code.
+ */
+struct parent {
+    entt::entity widget = entt::null;
+};
+
+template<>
+struct component_info<gold::style_names> {
+    static constexpr std::string_view public_name = "Style";
+    static constexpr std::string_view key = "style";
+};
+}
+
+namespace konbu {
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config, gold::style_names & names,
+                                     error_output & errors);
+}
+namespace YAML {
+template<>
+struct convert<gold::style_names> {
+    static Node encode(gold::style_names const & names);
+};
+}
+#include "gold/impl/style_names.tcc"
@@ -0,0 +1,154 @@
+#pragma once
+#include "gold/component.hpp"
+#include "gold/style_names.hpp"
+
+#include <entt/entity/registry.hpp>
+#include <yaml-cpp/yaml.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+inline namespace gold {
+
+/** A tag and classes a widget must all have, e.g. `button.primary` */
+struct compound_selector {
+    std::string tag; // empty or "*" selects any tag
+    std::vector<std::string> classes;
+
+    [[nodiscard]] bool matches(gold::style_names const & names) const;
+};
+
+/** How two compound selectors relate in the widget hierarchy */
+enum class combinator {
+    descendant, /** `a b` selects b nested anywhere in a */
+    child       /** `a > b` selects b directly nested in a */
+};
+
+/** A chain of compound selectors, e.g. `panel > button.primary` */
+struct selector {
+    // parts[i] relates to parts[i + 1] by combinators[i]
+    std::vector<gold::compound_selector> parts;
+    std::vector<gold::combinator> combinators;
+
+    /** Parse a selector from css-like text. */
+    [[nodiscard]] static std::expected<gold::selector, std::string>
+    parse(std::string_view text);
+
+    /** Classes count more than tags, as in css. */
+    [[nodiscard]] std::uint32_t specificity() const;
+
+    /** Determine if the selector matches a widget and its ancestors. */
+    [[nodiscard]] bool matches(entt::registry const & widgets,
+                               entt::entity widget) const;
+};
+
+/** The cascade result cached on a widget. */
+struct computed_style {
+    // the rules that matched the widget, in cascade order
+    std::vector<std::uint32_t> rules;
+    // the sheet and rule versions the result was computed with
+    std::uint64_t version = 0u;
+    // components written by the cascade, rather than by the widget itself
+    std::uint64_t applied = 0u;
+    bool stale = true;
+
+    /**
+     * \brief Determine if the cascade wrote a component, rather than the widget
+     * \param index     the index of the component in gold::widget_components
+     */
+    [[nodiscard]] inline bool applies(std::size_t index) const
+    {
+        return (applied >> index) & 1u;
+    }
+};
+
+/**
+ * \brief Rules that style widgets by selector, with a css-like cascade
+ *
+ * Rules are indexed by the rightmost part of their selector, so a widget is
+ * only tested against rules that name its tag or one of its classes, and
+ * rules that select any widget.
+ */
+class style_sheet {
+public:
+    /**
+     * \brief Add a rule to the sheet
+     *
+     * \param rule_selector which widgets the rule applies to
+     * \param declarations  yaml widget components the rule sets
+     *
+     * \return the index of the rule
+     */
+    template<std::ranges::output_range<YAML::Exception> error_output>
+    std::uint32_t add_rule(gold::selector rule_selector,
+                           YAML::Node const & declarations,
+                           error_output & errors);
+
+    /** Replace the declarations of a rule. */
+    template<std::ranges::output_range<YAML::Exception> error_output>
+    void set_declarations(std::uint32_t rule,
+                          YAML::Node const & declarations,
+                          error_output & errors);
+
+    /**
+     * \brief Compute the style of every widget whose cache is out of date
+     *
+     * Components set by a widget itself override the style sheet, the same as
+     * inline styles in css.
+     */
+    void restyle(entt::registry & widgets) const;
+
+    /**
+     * \brief Mark the computed style of a widget and of the widgets nested in
+     *        it as needing to be recomputed
+     */
+    static void invalidate(entt::registry & widgets, entt::entity widget);
+
+    /**
+     * \brief Recompute styles when the style names or parent of a widget are
+     *        added, replaced, patched or removed
+     */
+    static void watch(entt::registry & widgets);
+
+    [[nodiscard]] inline std::size_t size() const { return rules.size(); }
+private:
+    struct rule {
+        gold::selector target;
+        entt::entity declarations;
+        std::uint32_t specificity;
+        std::uint64_t version;
+    };
+    [[nodiscard]] std::vector<std::uint32_t>
+    match(entt::registry const & widgets, entt::entity widget,
+          gold::style_names const & names) const;
+    [[nodiscard]] bool is_current(gold::computed_style const & style) const;
+    void apply(entt::registry & widgets, entt::entity widget,
+               gold::computed_style & style) const;
+
+    std::vector<rule> rules;
+    // rule declarations are read into their own registry, one entity per rule
+    entt::registry declarations;
+    // bumped whenever rules are added or changed
+    std::uint64_t version = 1u;
+    // the version when a rule was last added, which may change any match
+    std::uint64_t structure_version = 1u;
+
+    std::unordered_map<std::string, std::vector<std::uint32_t>> by_tag;
+    std::unordered_map<std::string, std::vector<std::uint32_t>> by_class;
+    std::vector<std::uint32_t> universal;
+};
+}
+
+namespace konbu {
+/** Read a style sheet: a map of selectors to widget declarations. */
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config, gold::style_sheet & sheet,
+                                     error_output & errors);
+}
+#include "gold/impl/style_sheet.tcc"
@@ -1,10 +1,23 @@
 #pragma once
+// style names are read by widgets, so their reader is declared first
+#include "gold/style_names.hpp"
+#include "gold/layout.hpp"
+#include "gold/size.hpp"
+#include "gold/background_color.hpp"
+#include "gold/compact.hpp"
+#include "gold/component_set.hpp"
 
 #include <entt/entity/registry.hpp>
 #include <filesystem>
 #include <yaml-cpp/yaml.h>
 #include <ranges>
 
+inline namespace gold {
+/** The components every widget may be made of. */
+using widget_components = gold::component_set<gold::layout,
+                                              gold::size,
+                                              gold::background_color>;
+}
 namespace konbu {
 template<std::ranges::output_range<YAML::Exception> error_output>
 entt::entity read_widget(YAML::Node const & config,
@@ -20,4 +33,4 @@ bool write(std::filesystem::path const & path,
            entt::registry const & widgets,
            entt::entity widget);
 }
-#include "gold/impl/widget.tcc"
\ No newline at end of file
+#include "gold/impl/widget.tcc"
@@ -1,11 +1,18 @@
 #pragma once
+#include "ion/jobs.hpp"
+
+#include <algorithm>
+#include <cstddef>
 #include <expected>
+#include <numeric>
 #include <vector>
 #include <utility>
 
 // type constraints
 #include <ranges>
 #include <iterator>
+#include <concepts>
+#include <type_traits>
 
 namespace ion {
 
@@ -34,4 +41,143 @@ expected_partition(Range && results, OutputIterator output,
     }
     return std::make_pair(output, errors);
 }
+
+/**
+ * \brief Split results into values and errors on a job pool
+ *
+ * \param pool      runs the chunks
+ * \param results   random-access range of std::expected results, moved from
+ * \param values    the values are appended to
+ * \param errors    the errors are appended to
+ * \param grain     results per chunk, or 0 to pick one
+ *
+ * One parallel pass counts the values in each chunk. The outputs are then
+ * resized exactly once, and a second pass moves each chunk's values and
+ * errors to their final places. Both outputs keep the order of `results`.
+ */
+template<std::ranges::random_access_range Range>
+requires std::ranges::sized_range<Range>
+     and std::default_initializable<
+            typename std::ranges::range_value_t<Range>::value_type>
+     and std::default_initializable<
+            typename std::ranges::range_value_t<Range>::error_type>
+void expected_partition(
+    ion::jobs & pool, Range && results,
+    std::vector<typename std::ranges::range_value_t<Range>::value_type> & values,
+    std::vector<typename std::ranges::range_value_t<Range>::error_type> & errors,
+    std::size_t grain = 0u);
+}
+
+namespace ion::views {
+
+// results of an rvalue reference may be temporaries, made by dereferencing a
+// range of prvalues, so their value or error is returned by value
+/** A view of the values of a range of std::expected results */
+inline constexpr auto values =
+    std::views::filter([](auto const & result) { return result.has_value(); })
+  | std::views::transform([](auto && result) -> decltype(auto) {
+        if constexpr (std::is_rvalue_reference_v<decltype(result)>) {
+            return std::remove_cvref_t<decltype(*result)>(*std::move(result));
+        }
+        else {
+            return *result;
+        }
+    });
+
+/** A view of the errors of a range of std::expected results */
+inline constexpr auto errors =
+    std::views::filter([](auto const & result) { return not result.has_value(); })
+  | std::views::transform([](auto && result) -> decltype(auto) {
+        if constexpr (std::is_rvalue_reference_v<decltype(result)>) {
+            return std::remove_cvref_t<decltype(result.error())>(
+                std::move(result).error());
+        }
+        else {
+            return result.error();
+        }
+    });
+}
+
+namespace ion {
+
+/**
+ * \brief Lazily split results into values and errors
+ * \return a pair of views, of the values and of the errors
+ *
+ * Each view filters `results` as it's iterated. Values and errors of results
+ * that are lvalues aren't copied, those of prvalue results are moved out.
+ */
+template<std::ranges::viewable_range Range>
+auto expected_views(Range && results)
+{
+    auto all = std::views::all(std::forward<Range>(results));
+    return std::pair{ all | ion::views::values, all | ion::views::errors };
+}
+}
+
+template<std::ranges::random_access_range Range>
+requires std::ranges::sized_range<Range>
+     and std::default_initializable<
+            typename std::ranges::range_value_t<Range>::value_type>
+     and std::default_initializable<
+            typename std::ranges::range_value_t<Range>::error_type>
+void ion::expected_partition(
+    ion::jobs & pool, Range && results,
+    std::vector<typename std::ranges::range_value_t<Range>::value_type> & values,
+    std::vector<typename std::ranges::range_value_t<Range>::error_type> & errors,
+    std::size_t grain)
+{
+    auto const size = static_cast<std::size_t>(std::ranges::size(results));
+    if (size == 0u) {
+        return;
+    }
+    if (grain == 0u) {
+        // a few chunks per thread, and not so small the passes cost more
+        std::size_t const threads = pool.worker_count() + 1u;
+        grain = std::max<std::size_t>(size / (threads * 4u), 256u);
+    }
+    std::size_t const chunk_count = (size + grain - 1u) / grain;
+    std::vector<std::size_t> chunks(chunk_count);
+    std::iota(chunks.begin(), chunks.end(), std::size_t{ 0u });
+
+    auto const first = std::ranges::begin(results);
+    using difference = std::ranges::range_difference_t<Range>;
+    auto const at = [first](std::size_t i) -> decltype(auto) {
+        return first[static_cast<difference>(i)];
+    };
+
+    // count the values of each chunk, then offset each chunk by the chunks
+    // before it
+    std::vector<std::size_t> value_offsets(chunk_count + 1u, 0u);
+    pool.parallel_for(chunks, [&](std::size_t chunk) {
+        std::size_t const end = std::min(chunk * grain + grain, size);
+        std::size_t count = 0u;
+        for (std::size_t i = chunk * grain; i < end; ++i) {
+            count += at(i).has_value() ? 1u : 0u;
+        }
+        value_offsets[chunk + 1u] = count;
+    }, 1u);
+    std::partial_sum(value_offsets.begin(), value_offsets.end(),
+                     value_offsets.begin());
+
+    std::size_t const value_base = values.size();
+    std::size_t const error_base = errors.size();
+    values.resize(value_base + value_offsets.back());
+    errors.resize(error_base + size - value_offsets.back());
+
+    pool.parallel_for(chunks, [&](std::size_t chunk) {
+        std::size_t const begin = chunk * grain;
+        std::size_t const end = std::min(begin + grain, size);
+        std::size_t value = value_base + value_offsets[chunk];
+        std::size_t error = error_base + begin - value_offsets[chunk];
+        for (std::size_t i = begin; i < end; ++i) {
+            auto && result = at(i);
+            if (not result) {
+                errors[error++] = std::move(result).error();
+            }
+            else {
+                values[value++] = *std::move(result);
+            }
+        }
+    }, 1u);
 }
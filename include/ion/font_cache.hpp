@@ -0,0 +1,416 @@
+#pragma once
+#define IMGUI_DEFINE_MATH_OPERATORS
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace ion {
+
+/**
+ * \brief Hash everything that changes how a font atlas is built
+ *
+ * The key covers the font data, sizes, glyph ranges and rasterizer settings
+ * of every font added to the atlas, along with the imgui version.
+ *
+ * \param atlas an atlas with its fonts added, built or not
+ */
+[[nodiscard]] std::uint64_t font_atlas_key(ImFontAtlas const & atlas);
+
+/** \brief The file an atlas with the given key is cached in. */
+[[nodiscard]] std::filesystem::path
+font_cache_path(std::filesystem::path const & directory, std::uint64_t key);
+
+/**
+ * \brief Write the pixels and glyph tables of a built atlas to disk
+ *
+ * \param path  the file to write, replaced as a whole
+ * \param key   the key of the atlas, from font_atlas_key
+ * \param atlas an atlas that was built with 8-bit alpha pixels
+ *
+ * \return true if the cache was written
+ */
+bool save_font_atlas(std::filesystem::path const & path, std::uint64_t key,
+                     ImFontAtlas const & atlas);
+
+/**
+ * \brief Load a cached atlas, skipping rasterization
+ *
+ * \param path  the file to read
+ * \param key   the key the cache must have been saved with
+ * \param atlas an atlas with the same fonts added as when it was saved
+ *
+ * \return true if the atlas was loaded and is ready to use. The atlas is left
+ *         unchanged if the cache was missing, stale or corrupt.
+ */
+bool load_font_atlas(std::filesystem::path const & path, std::uint64_t key,
+                     ImFontAtlas & atlas);
+}
+
+namespace ion::detail {
+
+// identifies a file as a font atlas cache, and the layout of its contents
+inline std::uint32_t constexpr font_cache_magic = 0x666e6f69u; // "ionf"
+inline std::uint32_t constexpr font_cache_version = 1u;
+
+// textures larger than this are more likely a corrupt cache than real
+inline int constexpr max_font_texture_size = 16384;
+
+/** 64-bit FNV-1a, fed one value at a time */
+struct fnv1a {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+
+    inline void operator()(void const * data, std::size_t size)
+    {
+        auto const * bytes = static_cast<unsigned char const *>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    }
+    template<typename value>
+    requires std::is_trivially_copyable_v<value>
+    inline void operator()(value const & input)
+    {
+        (*this)(&input, sizeof(input));
+    }
+};
+
+class font_cache_writer {
+public:
+    inline explicit font_cache_writer(std::filesystem::path const & path)
+        : file{ path, std::ios_base::binary | std::ios_base::trunc }
+    {
+    }
+    inline void write(void const * data, std::size_t size)
+    {
+        file.write(static_cast<char const *>(data),
+                   static_cast<std::streamsize>(size));
+    }
+    template<typename value>
+    requires std::is_trivially_copyable_v<value>
+    inline void operator()(value const & output)
+    {
+        write(&output, sizeof(output));
+    }
+    [[nodiscard]] inline bool ok() { return file.good(); }
+    inline void close() { file.close(); }
+private:
+    std::ofstream file;
+};
+
+class font_cache_reader {
+public:
+    inline explicit font_cache_reader(std::filesystem::path const & path)
+        : file{ path, std::ios_base::binary }
+    {
+    }
+    inline void read(void * data, std::size_t size)
+    {
+        file.read(static_cast<char *>(data),
+                  static_cast<std::streamsize>(size));
+    }
+    template<typename value>
+    requires std::is_trivially_copyable_v<value>
+    inline void operator()(value & input)
+    {
+        read(&input, sizeof(input));
+    }
+    [[nodiscard]] inline bool ok() { return file.good(); }
+    [[nodiscard]] inline bool at_end()
+    {
+        return file.peek() == std::ifstream::traits_type::eof();
+    }
+private:
+    std::ifstream file;
+};
+
+inline int font_index(ImFontAtlas const & atlas, ImFont const * font)
+{
+    if (not font) {
+        return -1;
+    }
+    auto const * const begin = atlas.Fonts.begin();
+    auto const * const end = atlas.Fonts.end();
+    auto const * const search = std::find(begin, end, font);
+    return search != end ? static_cast<int>(search - begin) : -1;
+}
+
+/** The glyph tables of one font, as cached */
+struct cached_font {
+    float size;
+    float ascent;
+    float descent;
+    ImWchar fallback_char;
+    ImWchar ellipsis_char;
+    ImWchar dot_char;
+    std::vector<ImFontGlyph> glyphs;
+};
+}
+
+inline std::uint64_t ion::font_atlas_key(ImFontAtlas const & atlas)
+{
+    detail::fnv1a hash;
+    hash(detail::font_cache_version);
+    hash(IMGUI_VERSION_NUM);
+    hash(atlas.Flags);
+    hash(atlas.TexDesiredWidth);
+    hash(atlas.TexGlyphPadding);
+    hash(atlas.FontBuilderFlags);
+    hash(atlas.Fonts.Size);
+
+    // hashed field by field, since the structs have padding
+    for (ImFontConfig const & config : atlas.ConfigData) {
+        hash(config.FontData, static_cast<std::size_t>(config.FontDataSize));
+        hash(config.FontNo);
+        hash(config.SizePixels);
+        hash(config.OversampleH);
+        hash(config.OversampleV);
+        hash(config.PixelSnapH);
+        hash(config.GlyphExtraSpacing.x);
+        hash(config.GlyphExtraSpacing.y);
+        hash(config.GlyphOffset.x);
+        hash(config.GlyphOffset.y);
+        hash(config.GlyphMinAdvanceX);
+        hash(config.GlyphMaxAdvanceX);
+        hash(config.MergeMode);
+        hash(config.FontBuilderFlags);
+        hash(config.RasterizerMultiply);
+        hash(config.EllipsisChar);
+        hash(detail::font_index(atlas, config.DstFont));
+        for (ImWchar const * range = config.GlyphRanges;
+             range and *range; ++range) {
+            hash(*range);
+        }
+        hash(ImWchar{ 0 });
+    }
+    for (ImFontAtlasCustomRect const & rect : atlas.CustomRects) {
+        hash(rect.Width);
+        hash(rect.Height);
+        hash(rect.GlyphID);
+        hash(rect.GlyphAdvanceX);
+        hash(rect.GlyphOffset.x);
+        hash(rect.GlyphOffset.y);
+        hash(detail::font_index(atlas, rect.Font));
+    }
+    return hash.hash;
+}
+
+inline std::filesystem::path
+ion::font_cache_path(std::filesystem::path const & directory, std::uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "fonts-%016llx.atlas",
+                  static_cast<unsigned long long>(key));
+    return directory / name;
+}
+
+inline bool ion::save_font_atlas(std::filesystem::path const & path,
+                                 std::uint64_t key, ImFontAtlas const & atlas)
+{
+    namespace fs = std::filesystem;
+
+    if (not atlas.TexReady or not atlas.TexPixelsAlpha8) {
+        return false;
+    }
+    std::error_code error;
+    if (path.has_parent_path()) {
+        fs::create_directories(path.parent_path(), error);
+        if (error) {
+            return false;
+        }
+    }
+    // write beside the cache, then swap it in, so readers never see half
+    fs::path temporary = path;
+    temporary += ".tmp";
+    {
+        detail::font_cache_writer output{ temporary };
+        output(detail::font_cache_magic);
+        output(detail::font_cache_version);
+        output(key);
+
+        output(atlas.TexWidth);
+        output(atlas.TexHeight);
+        output(atlas.TexUvScale);
+        output(atlas.TexUvWhitePixel);
+        output(atlas.TexUvLines);
+        output(atlas.PackIdMouseCursors);
+        output(atlas.PackIdLines);
+
+        output(atlas.CustomRects.Size);
+        for (ImFontAtlasCustomRect const & rect : atlas.CustomRects) {
+            output(rect.Width);
+            output(rect.Height);
+            output(rect.X);
+            output(rect.Y);
+            output(rect.GlyphID);
+            output(rect.GlyphAdvanceX);
+            output(rect.GlyphOffset);
+            output(detail::font_index(atlas, rect.Font));
+        }
+        output.write(atlas.TexPixelsAlpha8,
+                     static_cast<std::size_t>(atlas.TexWidth) *
+                     static_cast<std::size_t>(atlas.TexHeight));
+
+        output(atlas.Fonts.Size);
+        for (ImFont const * font : atlas.Fonts) {
+            output(font->FontSize);
+            output(font->Ascent);
+            output(font->Descent);
+            output(font->FallbackChar);
+            output(font->EllipsisChar);
+            output(font->DotChar);
+            output(font->Glyphs.Size);
+            output.write(font->Glyphs.Data,
+                         static_cast<std::size_t>(font->Glyphs.size_in_bytes()));
+        }
+        output.close();
+        if (not output.ok()) {
+            fs::remove(temporary, error);
+            return false;
+        }
+    }
+    fs::rename(temporary, path, error);
+    return not error;
+}
+
+inline bool ion::load_font_atlas(std::filesystem::path const & path,
+                                 std::uint64_t key, ImFontAtlas & atlas)
+{
+    static_assert(std::is_trivially_copyable_v<ImFontGlyph>);
+
+    detail::font_cache_reader input{ path };
+    std::uint32_t magic = 0u;
+    std::uint32_t version = 0u;
+    std::uint64_t saved_key = 0u;
+    input(magic);
+    input(version);
+    input(saved_key);
+    if (not input.ok() or magic != detail::font_cache_magic
+                       or version != detail::font_cache_version
+                       or saved_key != key) {
+        return false;
+    }
+
+    // read everything before touching the atlas, so a bad cache changes nothing
+    int width = 0;
+    int height = 0;
+    ImVec2 uv_scale;
+    ImVec2 uv_white_pixel;
+    ImVec4 uv_lines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+    int pack_id_mouse_cursors = -1;
+    int pack_id_lines = -1;
+    input(width);
+    input(height);
+    input(uv_scale);
+    input(uv_white_pixel);
+    input(uv_lines);
+    input(pack_id_mouse_cursors);
+    input(pack_id_lines);
+
+    int rect_count = 0;
+    input(rect_count);
+    if (not input.ok() or rect_count < 0
+                       or width <= 0 or width > detail::max_font_texture_size
+                       or height <= 0 or height > detail::max_font_texture_size) {
+        return false;
+    }
+    std::vector<ImFontAtlasCustomRect> rects(static_cast<std::size_t>(rect_count));
+    std::vector<int> rect_fonts(rects.size());
+    for (std::size_t i = 0; i < rects.size() and input.ok(); ++i) {
+        input(rects[i].Width);
+        input(rects[i].Height);
+        input(rects[i].X);
+        input(rects[i].Y);
+        input(rects[i].GlyphID);
+        input(rects[i].GlyphAdvanceX);
+        input(rects[i].GlyphOffset);
+        input(rect_fonts[i]);
+    }
+    std::vector<unsigned char> pixels(static_cast<std::size_t>(width) *
+                                      static_cast<std::size_t>(height));
+    input.read(pixels.data(), pixels.size());
+
+    int font_count = 0;
+    input(font_count);
+    if (not input.ok() or font_count != atlas.Fonts.Size) {
+        return false;
+    }
+    std::vector<detail::cached_font> fonts(static_cast<std::size_t>(font_count));
+    for (auto & font : fonts) {
+        input(font.size);
+        input(font.ascent);
+        input(font.descent);
+        input(font.fallback_char);
+        input(font.ellipsis_char);
+        input(font.dot_char);
+        int glyph_count = 0;
+        input(glyph_count);
+        if (not input.ok() or glyph_count < 0) {
+            return false;
+        }
+        font.glyphs.resize(static_cast<std::size_t>(glyph_count));
+        input.read(font.glyphs.data(), font.glyphs.size() * sizeof(ImFontGlyph));
+    }
+    if (not input.ok() or not input.at_end()) {
+        return false;
+    }
+    for (int const font : rect_fonts) {
+        if (font < -1 or font >= font_count) {
+            return false;
+        }
+    }
+
+    // restore the atlas the same way building it would have left it
+    atlas.ClearTexData();
+    atlas.TexWidth = width;
+    atlas.TexHeight = height;
+    atlas.TexUvScale = uv_scale;
+    atlas.TexUvWhitePixel = uv_white_pixel;
+    std::copy(std::begin(uv_lines), std::end(uv_lines),
+              std::begin(atlas.TexUvLines));
+    atlas.PackIdMouseCursors = pack_id_mouse_cursors;
+    atlas.PackIdLines = pack_id_lines;
+    atlas.TexPixelsAlpha8 = static_cast<unsigned char *>(IM_ALLOC(pixels.size()));
+    std::memcpy(atlas.TexPixelsAlpha8, pixels.data(), pixels.size());
+
+    atlas.CustomRects.resize(rect_count);
+    for (int i = 0; i < rect_count; ++i) {
+        auto const font = rect_fonts[static_cast<std::size_t>(i)];
+        rects[static_cast<std::size_t>(i)].Font =
+            font < 0 ? nullptr : atlas.Fonts[font];
+        atlas.CustomRects[i] = rects[static_cast<std::size_t>(i)];
+    }
+    for (ImFontConfig & config : atlas.ConfigData) {
+        auto const index = detail::font_index(atlas, config.DstFont);
+        if (index < 0) {
+            continue;
+        }
+        auto const & font = fonts[static_cast<std::size_t>(index)];
+        ImFontAtlasBuildSetupFont(&atlas, config.DstFont, &config,
+                                  font.ascent, font.descent);
+    }
+    for (int i = 0; i < font_count; ++i) {
+        auto & cached = fonts[static_cast<std::size_t>(i)];
+        ImFont * font = atlas.Fonts[i];
+        font->FontSize = cached.size;
+        font->FallbackChar = cached.fallback_char;
+        font->EllipsisChar = cached.ellipsis_char;
+        font->DotChar = cached.dot_char;
+        font->Glyphs.resize(static_cast<int>(cached.glyphs.size()));
+        std::memcpy(font->Glyphs.Data, cached.glyphs.data(),
+                    cached.glyphs.size() * sizeof(ImFontGlyph));
+        font->BuildLookupTable();
+    }
+    atlas.TexReady = true;
+    return true;
+}
@@ -1,8 +1,19 @@
 #pragma once
-#include <functional>
+#include "ion/jobs.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
-#include <unordered_map>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace ion {
 
@@ -21,11 +32,173 @@ requires(F && hash_fn, T && elem)
 };
 
 /**
- * \brief a basic unordered histogram type
+ * \brief A key with few enough values to count in a plain array
+ *
+ * Single-byte integers and enums qualify, e.g. `ion::phase`.
+ */
+template<typename T>
+concept dense_key = std::regular<T>
+                and (std::integral<T> or std::is_enum_v<T>)
+                and sizeof(T) == 1u;
+
+/** A key of a histogram and how many times it was counted */
+template<typename T>
+struct histogram_entry {
+    T key;
+    std::uint32_t count;
+};
+
+/**
+ * \brief an unordered histogram type
  * \tparam T    the type to count
+ *
+ * Keys and counts live in one flat array, probed linearly from the key's
+ * hash, so counting doesn't allocate per key or chase pointers. Iterating
+ * visits each counted key once, in no particular order.
  */
 template<std::regular T, hash_for<T> Hash = std::hash<T>>
-using histogram = std::unordered_map<T, std::uint32_t, Hash>;
+class histogram {
+public:
+    using key_type = T;
+    using count_type = std::uint32_t;
+    using entry = ion::histogram_entry<T>;
+
+    class iterator {
+    public:
+        using value_type = entry;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        inline entry const & operator*() const { return *slot; }
+        inline entry const * operator->() const { return slot; }
+        iterator & operator++();
+        iterator operator++(int);
+        inline bool operator==(iterator const & rhs) const
+        {
+            return slot == rhs.slot;
+        }
+    private:
+        friend class histogram;
+        iterator(entry const * slot, entry const * last);
+        void skip_empty();
+        entry const * slot = nullptr;
+        entry const * last = nullptr;
+    };
+
+    histogram() = default;
+    explicit histogram(Hash hash);
+
+    /** Count a key `n` more times. */
+    void add(T const & key, count_type n = 1u);
+
+    /** How many times a key was counted. */
+    [[nodiscard]] count_type count(T const & key) const;
+
+    /** The number of distinct keys counted. */
+    [[nodiscard]] inline std::size_t size() const { return used; }
+    [[nodiscard]] inline bool empty() const { return used == 0u; }
+    /** The sum of every count. */
+    [[nodiscard]] std::uint64_t total() const;
+
+    /** Make room for a number of distinct keys without growing. */
+    void reserve(std::size_t keys);
+    void clear();
+
+    /** Add every count of another histogram. */
+    void merge(histogram const & other);
+
+    [[nodiscard]] iterator begin() const;
+    [[nodiscard]] iterator end() const;
+private:
+    // returns the slot of the key, or the empty slot where it belongs
+    [[nodiscard]] std::size_t find(T const & key) const;
+    void rehash(std::size_t capacity);
+
+    // an empty slot has a count of 0
+    std::vector<entry> slots;
+    std::size_t used = 0u;
+    // turns a hash into a slot index, by keeping its top bits
+    unsigned shift = 64u;
+    [[no_unique_address]] Hash hash;
+};
+
+/**
+ * \brief A histogram of single-byte keys, counted in a plain array
+ *
+ * Counting is an increment of the key's array element, and merging adds two
+ * arrays, which compilers vectorize. Iterating visits keys by their byte
+ * value.
+ */
+template<ion::dense_key T, hash_for<T> Hash>
+class histogram<T, Hash> {
+public:
+    using key_type = T;
+    using count_type = std::uint32_t;
+    using entry = ion::histogram_entry<T>;
+
+    class iterator {
+    public:
+        using value_type = entry;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        inline entry operator*() const
+        {
+            return { from_index(index), (*counts)[index] };
+        }
+        iterator & operator++();
+        iterator operator++(int);
+        inline bool operator==(iterator const & rhs) const
+        {
+            return index == rhs.index;
+        }
+    private:
+        friend class histogram;
+        iterator(std::array<count_type, 256u> const & counts, std::size_t index);
+        void skip_empty();
+        std::array<count_type, 256u> const * counts = nullptr;
+        std::size_t index = 256u;
+    };
+
+    histogram() = default;
+    inline explicit histogram(Hash) {}
+
+    inline void add(T const & key, count_type n = 1u)
+    {
+        counts[to_index(key)] += n;
+    }
+    [[nodiscard]] inline count_type count(T const & key) const
+    {
+        return counts[to_index(key)];
+    }
+
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] inline bool empty() const { return size() == 0u; }
+    [[nodiscard]] std::uint64_t total() const;
+
+    inline void reserve(std::size_t) {}
+    inline void clear() { counts.fill(0u); }
+
+    void merge(histogram const & other);
+
+    [[nodiscard]] iterator begin() const;
+    [[nodiscard]] iterator end() const;
+private:
+    using byte = std::conditional_t<std::is_enum_v<T>,
+                                    std::underlying_type<T>,
+                                    std::type_identity<T>>::type;
+
+    static inline std::size_t to_index(T key)
+    {
+        return static_cast<std::uint8_t>(static_cast<byte>(key));
+    }
+    static inline T from_index(std::size_t index)
+    {
+        return static_cast<T>(static_cast<byte>(static_cast<std::uint8_t>(index)));
+    }
+
+    std::array<count_type, 256u> counts{};
+};
 
 /**
  * \brief Add a histogram to another histogram
@@ -38,8 +211,353 @@ template<std::regular T, hash_for<T> Hash>
 auto add_all(histogram<T, Hash> & cumulative,
              histogram<T, Hash> const & transient)
 {
-    for (auto const &[key, count] : transient) {
-        cumulative[key] += count;
+    cumulative.merge(transient);
+}
+
+/**
+ * \brief Find the smallest key that at least a fraction of counts are at or
+ *        below, e.g. 0.99 for the 99th percentile
+ * \return the key, or nothing if the histogram is empty
+ */
+template<std::regular T, hash_for<T> Hash>
+requires std::totally_ordered<T>
+std::optional<T> percentile(histogram<T, Hash> const & counts, double fraction);
+
+/**
+ * \brief Find the most counted keys, most counted first
+ * \param k     the most keys to return
+ */
+template<std::regular T, hash_for<T> Hash>
+std::vector<ion::histogram_entry<T>>
+top_k(histogram<T, Hash> const & counts, std::size_t k);
+
+/**
+ * \brief A histogram split into a shard per thread of a job pool
+ *
+ * Each thread counts into its own shard, without locking, and `merge` adds
+ * the shards together pairwise, in parallel rounds. Shards are padded so
+ * threads counting at the same time don't share cache lines.
+ *
+ * \note Every thread outside the pool shares the last shard, so only one
+ *       of them may count at a time.
+ */
+template<std::regular T, hash_for<T> Hash = std::hash<T>>
+class sharded_histogram {
+public:
+    using histogram_type = ion::histogram<T, Hash>;
+
+    /** Make a shard for each worker of a pool, and one for other threads. */
+    explicit sharded_histogram(ion::jobs const & pool);
+
+    /** The shard of the calling thread. */
+    [[nodiscard]] histogram_type & local();
+
+    [[nodiscard]] inline histogram_type & shard(std::size_t index)
+    {
+        return shards[index].counts;
+    }
+    [[nodiscard]] inline std::size_t shard_count() const
+    {
+        return shards.size();
+    }
+
+    /**
+     * \brief Add every shard together, leaving the shards empty
+     * \param pool  merges pairs of shards in parallel, or null to merge them
+     *              on this thread
+     */
+    [[nodiscard]] histogram_type merge(ion::jobs * pool = nullptr);
+private:
+    struct alignas(64) padded {
+        histogram_type counts;
+    };
+    ion::jobs const * owner;
+    std::vector<padded> shards;
+};
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline ion::histogram<T, Hash>::iterator::iterator(entry const * slot,
+                                                   entry const * last)
+    : slot{ slot }, last{ last }
+{
+    skip_empty();
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline void ion::histogram<T, Hash>::iterator::skip_empty()
+{
+    while (slot != last and slot->count == 0u) {
+        ++slot;
+    }
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline auto ion::histogram<T, Hash>::iterator::operator++() -> iterator &
+{
+    ++slot;
+    skip_empty();
+    return *this;
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline auto ion::histogram<T, Hash>::iterator::operator++(int) -> iterator
+{
+    auto const previous = *this;
+    ++*this;
+    return previous;
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline ion::histogram<T, Hash>::histogram(Hash hash) : hash{ std::move(hash) }
+{
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline std::size_t ion::histogram<T, Hash>::find(T const & key) const
+{
+    // spread hashes that are poor in their top bits, like integer identities
+    auto const mixed = static_cast<std::uint64_t>(std::invoke(hash, key))
+                     * 0x9e3779b97f4a7c15u;
+    std::size_t const mask = slots.size() - 1u;
+    auto index = static_cast<std::size_t>(mixed >> shift);
+    while (slots[index].count != 0u and not (slots[index].key == key)) {
+        index = (index + 1u) & mask;
     }
+    return index;
 }
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline void ion::histogram<T, Hash>::rehash(std::size_t capacity)
+{
+    auto previous = std::exchange(slots, std::vector<entry>(capacity));
+    shift = 64u - static_cast<unsigned>(std::countr_zero(capacity));
+    for (auto & slot : previous) {
+        if (slot.count != 0u) {
+            slots[find(slot.key)] = std::move(slot);
+        }
+    }
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline void ion::histogram<T, Hash>::reserve(std::size_t keys)
+{
+    // keep the table at most 3/4 full, so probes stay short
+    std::size_t const capacity =
+        std::bit_ceil(std::max<std::size_t>(keys + keys / 3u + 1u, 8u));
+    if (capacity > slots.size()) {
+        rehash(capacity);
+    }
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline void ion::histogram<T, Hash>::add(T const & key, count_type n)
+{
+    if (n == 0u) {
+        return;
+    }
+    if ((used + 1u) * 4u > slots.size() * 3u) {
+        rehash(std::max<std::size_t>(slots.size() * 2u, 8u));
+    }
+    auto & slot = slots[find(key)];
+    if (slot.count == 0u) {
+        slot.key = key;
+        ++used;
+    }
+    slot.count += n;
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline auto ion::histogram<T, Hash>::count(T const & key) const -> count_type
+{
+    return slots.empty() ? 0u : slots[find(key)].count;
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline std::uint64_t ion::histogram<T, Hash>::total() const
+{
+    std::uint64_t sum = 0u;
+    for (auto const & slot : slots) {
+        sum += slot.count;
+    }
+    return sum;
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline void ion::histogram<T, Hash>::clear()
+{
+    std::ranges::fill(slots, entry{ T{}, 0u });
+    used = 0u;
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline void ion::histogram<T, Hash>::merge(histogram const & other)
+{
+    reserve(used + other.used);
+    for (auto const & [key, count] : other) {
+        add(key, count);
+    }
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline auto ion::histogram<T, Hash>::begin() const -> iterator
+{
+    return { slots.data(), slots.data() + slots.size() };
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline auto ion::histogram<T, Hash>::end() const -> iterator
+{
+    auto const last = slots.data() + slots.size();
+    return { last, last };
+}
+
+template<ion::dense_key T, ion::hash_for<T> Hash>
+inline ion::histogram<T, Hash>::iterator::iterator(
+    std::array<count_type, 256u> const & counts, std::size_t index)
+    : counts{ &counts }, index{ index }
+{
+    skip_empty();
+}
+
+template<ion::dense_key T, ion::hash_for<T> Hash>
+inline void ion::histogram<T, Hash>::iterator::skip_empty()
+{
+    while (index < counts->size() and (*counts)[index] == 0u) {
+        ++index;
+    }
+}
+
+template<ion::dense_key T, ion::hash_for<T> Hash>
+inline auto ion::histogram<T, Hash>::iterator::operator++() -> iterator &
+{
+    ++index;
+    skip_empty();
+    return *this;
+}
+
+template<ion::dense_key T, ion::hash_for<T> Hash>
+inline auto ion::histogram<T, Hash>::iterator::operator++(int) -> iterator
+{
+    auto const previous = *this;
+    ++*this;
+    return previous;
+}
+
+template<ion::dense_key T, ion::hash_for<T> Hash>
+inline std::size_t ion::histogram<T, Hash>::size() const
+{
+    auto const counted = std::ranges::count_if(counts, [](auto count) {
+        return count != 0u;
+    });
+    return static_cast<std::size_t>(counted);
+}
+
+template<ion::dense_key T, ion::hash_for<T> Hash>
+inline std::uint64_t ion::histogram<T, Hash>::total() const
+{
+    std::uint64_t sum = 0u;
+    for (auto const count : counts) {
+        sum += count;
+    }
+    return sum;
+}
+
+template<ion::dense_key T, ion::hash_for<T> Hash>
+inline void ion::histogram<T, Hash>::merge(histogram const & other)
+{
+    for (std::size_t i = 0u; i < counts.size(); ++i) {
+        counts[i] += other.counts[i];
+    }
+}
+
+template<ion::dense_key T, ion::hash_for<T> Hash>
+inline auto ion::histogram<T, Hash>::begin() const -> iterator
+{
+    return { counts, 0u };
+}
+
+template<ion::dense_key T, ion::hash_for<T> Hash>
+inline auto ion::histogram<T, Hash>::end() const -> iterator
+{
+    return { counts, counts.size() };
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+requires std::totally_ordered<T>
+inline std::optional<T> ion::percentile(histogram<T, Hash> const & counts,
+                                        double fraction)
+{
+    std::vector<ion::histogram_entry<T>> entries(counts.begin(), counts.end());
+    if (entries.empty()) {
+        return std::nullopt;
+    }
+    std::ranges::sort(entries, {}, &ion::histogram_entry<T>::key);
+    std::uint64_t total = 0u;
+    for (auto const & entry : entries) {
+        total += entry.count;
+    }
+    auto const rank = std::max<std::uint64_t>(
+        static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0)
+                                             * static_cast<double>(total))),
+        1u);
+    std::uint64_t seen = 0u;
+    for (auto const & entry : entries) {
+        seen += entry.count;
+        if (seen >= rank) {
+            return entry.key;
+        }
+    }
+    return entries.back().key;
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline std::vector<ion::histogram_entry<T>>
+ion::top_k(histogram<T, Hash> const & counts, std::size_t k)
+{
+    std::vector<ion::histogram_entry<T>> entries(counts.begin(), counts.end());
+    k = std::min(k, entries.size());
+    auto const last = entries.begin() + static_cast<std::ptrdiff_t>(k);
+    std::ranges::partial_sort(entries, last, std::ranges::greater{},
+                              &ion::histogram_entry<T>::count);
+    entries.resize(k);
+    return entries;
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline ion::sharded_histogram<T, Hash>::sharded_histogram(ion::jobs const & pool)
+    : owner{ &pool }, shards(pool.worker_count() + 1u)
+{
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline auto ion::sharded_histogram<T, Hash>::local() -> histogram_type &
+{
+    return shards[owner->thread_index()].counts;
+}
+
+template<std::regular T, ion::hash_for<T> Hash>
+inline auto ion::sharded_histogram<T, Hash>::merge(ion::jobs * pool)
+    -> histogram_type
+{
+    // each round adds the shard `stride` along into every other shard, so
+    // the whole merge takes log2(shards) rounds
+    std::vector<std::size_t> targets;
+    for (std::size_t stride = 1u; stride < shards.size(); stride *= 2u) {
+        targets.clear();
+        for (std::size_t i = 0u; i + stride < shards.size(); i += stride * 2u) {
+            targets.push_back(i);
+        }
+        auto const add_pair = [this, stride](std::size_t target) {
+            auto & source = shards[target + stride].counts;
+            shards[target].counts.merge(source);
+            source.clear();
+        };
+        if (pool and targets.size() > 1u) {
+            pool->parallel_for(targets, add_pair, 1u);
+        } else {
+            std::ranges::for_each(targets, add_pair);
+        }
+    }
+    return std::exchange(shards.front().counts, histogram_type{});
 }
@@ -0,0 +1,289 @@
+#pragma once
+#include "ion/timer.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <system_error>
+#include <vector>
+
+namespace ion {
+
+/** The input and timing of one iteration of the main loop */
+struct input_frame {
+    std::vector<SDL_Event> events;
+    // the fixed updates run during the frame
+    std::uint32_t steps = 0u;
+    bool rendered = false;
+    // the time step imgui saw, if the frame was rendered
+    float delta_time = 0.f;
+};
+
+/**
+ * \brief Records the input of the main loop to a compact binary file
+ *
+ * Only input events are recorded: quitting, window, keyboard, text and
+ * mouse events. Each is written with just the bytes of its event type,
+ * followed by a short marker at the end of each frame.
+ */
+class input_recorder {
+public:
+    /**
+     * \brief Start a recording, replacing any file at the path
+     * \param update_rate   the fixed update rate the recording is made at
+     * \return true if the file could be opened
+     */
+    bool open(std::filesystem::path const & path, double update_rate);
+
+    /** Record an event, if it's an input event. */
+    void record(SDL_Event const & event);
+
+    /** Mark the end of a frame. */
+    void end_frame(std::uint32_t steps, bool rendered, float delta_time);
+
+    /** Determine if everything so far was written. */
+    [[nodiscard]] inline bool ok() const { return file.is_open() and file.good(); }
+private:
+    std::ofstream file;
+};
+
+/**
+ * \brief Reads back a recording, one frame at a time
+ */
+class input_replay {
+public:
+    /**
+     * \brief Load a recording
+     * \return true if the file is a recording this version can replay
+     */
+    bool open(std::filesystem::path const & path);
+
+    /**
+     * \brief Read the next frame of the recording
+     * \return false at the end of the recording, or if it's corrupt
+     */
+    bool next(ion::input_frame & frame);
+
+    /** The fixed update rate the recording was made at. */
+    [[nodiscard]] inline double update_rate() const { return rate; }
+
+    /** The number of frames read so far. */
+    [[nodiscard]] inline std::uint64_t frame_index() const { return frames; }
+private:
+    std::vector<std::byte> bytes;
+    std::size_t offset = 0u;
+    double rate = 60.0;
+    std::uint64_t frames = 0u;
+};
+
+/** How long one replayed frame took */
+struct frame_timing {
+    using duration = ion::performance_clock::duration;
+
+    std::uint64_t frame;
+    std::uint32_t events;
+    std::uint32_t steps;
+    // handling events and running updates
+    duration update;
+    // building and drawing the frame, if it was rendered
+    duration render;
+};
+
+/**
+ * \brief Write frame timings as csv, one frame per line
+ * \return true if the file was written
+ */
+bool write_timings(std::filesystem::path const & path,
+                   std::span<ion::frame_timing const> timings);
+}
+
+namespace ion::detail {
+
+// identifies a file as an input recording, and the layout of its records
+inline std::uint32_t constexpr recording_magic = 0x726e6f69u; // "ionr"
+inline std::uint32_t constexpr recording_version = 2u;
+
+enum class record_tag : std::uint8_t { event = 1u, frame = 2u };
+
+/** The bytes recorded for an event type, or 0 if it isn't recorded. */
+inline std::size_t recorded_event_size(std::uint32_t type)
+{
+    switch (type) {
+    case SDL_QUIT:
+        return sizeof(SDL_QuitEvent);
+    case SDL_WINDOWEVENT:
+        return sizeof(SDL_WindowEvent);
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        return sizeof(SDL_KeyboardEvent);
+    case SDL_TEXTINPUT:
+        return sizeof(SDL_TextInputEvent);
+    case SDL_MOUSEMOTION:
+        return sizeof(SDL_MouseMotionEvent);
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        return sizeof(SDL_MouseButtonEvent);
+    case SDL_MOUSEWHEEL:
+        return sizeof(SDL_MouseWheelEvent);
+    default:
+        return 0u;
+    }
+}
+}
+
+inline bool ion::input_recorder::open(std::filesystem::path const & path,
+                                      double update_rate)
+{
+    file.open(path, std::ios_base::binary | std::ios_base::trunc);
+    if (not file) {
+        return false;
+    }
+    file.write(reinterpret_cast<char const *>(&detail::recording_magic),
+               sizeof(detail::recording_magic));
+    file.write(reinterpret_cast<char const *>(&detail::recording_version),
+               sizeof(detail::recording_version));
+    file.write(reinterpret_cast<char const *>(&update_rate),
+               sizeof(update_rate));
+    return file.good();
+}
+
+inline void ion::input_recorder::record(SDL_Event const & event)
+{
+    std::size_t const size = detail::recorded_event_size(event.type);
+    if (size == 0u or not file.is_open()) {
+        return;
+    }
+    auto const tag = detail::record_tag::event;
+    file.write(reinterpret_cast<char const *>(&tag), sizeof(tag));
+    // every event type starts at the beginning of the union
+    file.write(reinterpret_cast<char const *>(&event),
+               static_cast<std::streamsize>(size));
+}
+
+inline void ion::input_recorder::end_frame(std::uint32_t steps, bool rendered,
+                                           float delta_time)
+{
+    if (not file.is_open()) {
+        return;
+    }
+    auto const tag = detail::record_tag::frame;
+    auto const was_rendered = static_cast<std::uint8_t>(rendered);
+    file.write(reinterpret_cast<char const *>(&tag), sizeof(tag));
+    // steps are unbounded, as max-steps is
+    file.write(reinterpret_cast<char const *>(&steps), sizeof(steps));
+    file.write(reinterpret_cast<char const *>(&was_rendered),
+               sizeof(was_rendered));
+    if (rendered) {
+        file.write(reinterpret_cast<char const *>(&delta_time),
+                   sizeof(delta_time));
+    }
+}
+
+inline bool ion::input_replay::open(std::filesystem::path const & path)
+{
+    std::ifstream file{ path, std::ios_base::binary };
+    if (not file) {
+        return false;
+    }
+    std::error_code error;
+    auto const size = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    bytes.resize(size);
+    file.read(reinterpret_cast<char *>(bytes.data()),
+              static_cast<std::streamsize>(size));
+    if (not file) {
+        return false;
+    }
+    std::uint32_t magic = 0u;
+    std::uint32_t version = 0u;
+    std::size_t constexpr header_size =
+        sizeof(magic) + sizeof(version) + sizeof(rate);
+    if (bytes.size() < header_size) {
+        return false;
+    }
+    std::memcpy(&magic, bytes.data(), sizeof(magic));
+    std::memcpy(&version, bytes.data() + sizeof(magic), sizeof(version));
+    std::memcpy(&rate, bytes.data() + sizeof(magic) + sizeof(version),
+                sizeof(rate));
+    offset = header_size;
+    frames = 0u;
+    return magic == detail::recording_magic
+       and version == detail::recording_version
+       and rate > 0.0;
+}
+
+inline bool ion::input_replay::next(ion::input_frame & frame)
+{
+    frame.events.clear();
+    auto const read = [this](void * data, std::size_t size) {
+        if (offset + size > bytes.size()) {
+            return false;
+        }
+        std::memcpy(data, bytes.data() + offset, size);
+        offset += size;
+        return true;
+    };
+    detail::record_tag tag;
+    while (read(&tag, sizeof(tag))) {
+        if (tag == detail::record_tag::event) {
+            SDL_Event event{};
+            if (not read(&event.type, sizeof(event.type))) {
+                return false;
+            }
+            std::size_t const size = detail::recorded_event_size(event.type);
+            if (size < sizeof(event.type) or
+                not read(reinterpret_cast<std::byte *>(&event) +
+                             sizeof(event.type),
+                         size - sizeof(event.type))) {
+                return false;
+            }
+            frame.events.push_back(event);
+            continue;
+        }
+        if (tag != detail::record_tag::frame) {
+            return false;
+        }
+        std::uint32_t steps = 0u;
+        std::uint8_t rendered = 0u;
+        if (not read(&steps, sizeof(steps)) or
+            not read(&rendered, sizeof(rendered))) {
+            return false;
+        }
+        frame.steps = steps;
+        frame.rendered = rendered != 0u;
+        frame.delta_time = 0.f;
+        if (frame.rendered and
+            not read(&frame.delta_time, sizeof(frame.delta_time))) {
+            return false;
+        }
+        ++frames;
+        return true;
+    }
+    return false;
+}
+
+inline bool ion::write_timings(std::filesystem::path const & path,
+                               std::span<ion::frame_timing const> timings)
+{
+    using milliseconds = std::chrono::duration<double, std::milli>;
+
+    std::ofstream file{ path, std::ios_base::trunc };
+    if (not file) {
+        return false;
+    }
+    file << "frame,events,steps,update_ms,render_ms\n";
+    for (auto const & [frame, events, steps, update, render] : timings) {
+        file << frame << ',' << events << ',' << steps << ','
+             << milliseconds{ update }.count() << ','
+             << milliseconds{ render }.count() << '\n';
+    }
+    return file.good();
+}
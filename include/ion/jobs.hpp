@@ -0,0 +1,483 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ion {
+
+class job_graph;
+namespace detail { struct job_pool; }
+
+/**
+ * \brief A work-stealing thread pool
+ *
+ * Each worker owns a deque of jobs. Workers run their newest jobs first and
+ * steal the oldest jobs of other workers when they run out. Threads waiting
+ * on jobs help run them instead of blocking.
+ *
+ * Register the pool as a subsystem, with `system.add_subsystem<ion::jobs>()`,
+ * so that everything in an application shares one pool. The main loop then
+ * drains the main thread queue once per frame.
+ *
+ * \note Jobs shouldn't throw; an escaping exception terminates the program.
+ */
+class jobs {
+public:
+    using task = std::move_only_function<void()>;
+
+    /** Tracks when a group of jobs has finished */
+    class handle {
+    public:
+        handle();
+        /** Determine if every job in the group has finished. */
+        [[nodiscard]] bool done() const;
+    private:
+        friend class jobs;
+        std::shared_ptr<std::atomic<std::size_t>> remaining;
+    };
+
+    /** Start a pool with one worker per core, besides the main thread. */
+    jobs();
+    explicit jobs(std::size_t worker_count);
+
+    /** Run every queued job, then stop the workers. */
+    ~jobs();
+
+    jobs(jobs &&) noexcept = default;
+    jobs & operator=(jobs &&) noexcept = default;
+
+    /** Run a job on a worker. */
+    handle submit(task job);
+
+    /** Run a job on a worker as part of a group. */
+    void submit(task job, handle & group);
+
+    /** Run jobs until every job in a group has finished. */
+    void wait(handle const & group);
+
+    /**
+     * \brief Run jobs in dependency order
+     *
+     * \return a handle for the whole graph, or an error if the graph has a
+     *         cycle.
+     */
+    [[nodiscard]] std::expected<handle, std::string> run(ion::job_graph graph);
+
+    /**
+     * \brief Call a function on each element of a range, in parallel
+     *
+     * \param values    the range to visit
+     * \param fn        called with each element, from any thread
+     * \param grain     the number of elements per job, or 0 to pick one
+     *
+     * Returns once every element has been visited.
+     */
+    template<std::ranges::random_access_range range, typename function>
+    requires std::ranges::sized_range<range> and
+             std::invocable<function &, std::ranges::range_reference_t<range>>
+    void parallel_for(range && values, function fn, std::size_t grain = 0u);
+
+    /** Queue a job to run on the main thread, e.g. to apply a result. */
+    void on_main_thread(task job);
+
+    /**
+     * \brief Run every job queued for the main thread
+     * \return the number of jobs run
+     */
+    std::size_t drain_main_thread();
+
+    /** Called when a main thread job is queued, to wake the main loop. */
+    void set_wake(void (*wake)());
+
+    [[nodiscard]] std::size_t worker_count() const;
+
+    /**
+     * \brief The index of the calling thread in the pool
+     * \return the worker's index, or `worker_count()` for any other thread
+     */
+    [[nodiscard]] std::size_t thread_index() const;
+private:
+    // try to run one job from this thread's deque or another's
+    bool run_one();
+
+    std::unique_ptr<detail::job_pool> pool;
+};
+
+/**
+ * \brief Jobs and the order they have to run in
+ *
+ * A job runs once every job that precedes it has finished, and jobs with no
+ * order between them may run at the same time.
+ */
+class job_graph {
+public:
+    using node = std::size_t;
+
+    /** Add a job to the graph. */
+    node add(ion::jobs::task job);
+
+    /** Make a job wait for another to finish first. */
+    void precede(node before, node after);
+
+    [[nodiscard]] inline std::size_t size() const { return vertices.size(); }
+private:
+    friend class jobs;
+    struct vertex {
+        ion::jobs::task job;
+        std::vector<node> successors;
+        std::size_t dependencies = 0u;
+    };
+    std::vector<vertex> vertices;
+};
+}
+
+namespace ion::detail {
+
+struct job_deque {
+    std::mutex mutex;
+    std::deque<ion::jobs::task> tasks;
+};
+
+struct job_pool {
+    std::vector<std::unique_ptr<job_deque>> deques;
+    std::vector<std::thread> workers;
+    // bumped whenever a job is queued, for idle workers to wait on
+    std::atomic<std::uint64_t> epoch = 0u;
+    std::atomic<std::size_t> next_deque = 0u;
+    std::atomic<bool> stopping = false;
+
+    std::mutex main_mutex;
+    std::vector<ion::jobs::task> main_tasks;
+    void (*wake)() = nullptr;
+
+    void push(ion::jobs::task job);
+    std::optional<ion::jobs::task> pop(std::size_t index);
+    std::optional<ion::jobs::task> steal(std::size_t thief);
+    std::optional<ion::jobs::task> find(std::size_t index);
+    void work(std::size_t index);
+};
+
+// the pool and deque of the worker running on this thread, if any
+struct job_worker {
+    job_pool * pool = nullptr;
+    std::size_t index = 0u;
+};
+inline thread_local job_worker current_worker;
+
+inline void job_pool::push(ion::jobs::task job)
+{
+    // workers keep their own jobs close, others spread them out
+    std::size_t const index = current_worker.pool == this
+                            ? current_worker.index
+                            : next_deque.fetch_add(1u) % deques.size();
+    {
+        std::scoped_lock const lock{ deques[index]->mutex };
+        deques[index]->tasks.push_back(std::move(job));
+    }
+    epoch.fetch_add(1u);
+    epoch.notify_one();
+}
+
+inline std::optional<ion::jobs::task> job_pool::pop(std::size_t index)
+{
+    auto & deque = *deques[index];
+    std::scoped_lock const lock{ deque.mutex };
+    if (deque.tasks.empty()) {
+        return std::nullopt;
+    }
+    auto job = std::move(deque.tasks.back());
+    deque.tasks.pop_back();
+    return job;
+}
+
+inline std::optional<ion::jobs::task> job_pool::steal(std::size_t thief)
+{
+    for (std::size_t i = 1u; i <= deques.size(); ++i) {
+        auto & deque = *deques[(thief + i) % deques.size()];
+        std::scoped_lock const lock{ deque.mutex };
+        if (not deque.tasks.empty()) {
+            auto job = std::move(deque.tasks.front());
+            deque.tasks.pop_front();
+            return job;
+        }
+    }
+    return std::nullopt;
+}
+
+inline std::optional<ion::jobs::task> job_pool::find(std::size_t index)
+{
+    if (auto job = pop(index)) {
+        return job;
+    }
+    return steal(index);
+}
+
+inline void job_pool::work(std::size_t index)
+{
+    current_worker = { this, index };
+    while (true) {
+        std::uint64_t const seen = epoch.load();
+        if (auto job = find(index)) {
+            (*job)();
+            continue;
+        }
+        // queued jobs still run after stopping
+        if (stopping.load()) {
+            break;
+        }
+        epoch.wait(seen);
+    }
+    current_worker = {};
+}
+}
+
+inline ion::jobs::handle::handle()
+    : remaining{ std::make_shared<std::atomic<std::size_t>>(0u) }
+{
+}
+
+inline bool ion::jobs::handle::done() const
+{
+    return remaining->load() == 0u;
+}
+
+inline ion::jobs::jobs()
+    : jobs{ std::max(std::thread::hardware_concurrency(), 2u) - 1u }
+{
+}
+
+inline ion::jobs::jobs(std::size_t worker_count)
+    : pool{ std::make_unique<detail::job_pool>() }
+{
+    // without workers, jobs still run on threads that wait for them
+    for (std::size_t i = 0u; i < std::max<std::size_t>(worker_count, 1u); ++i) {
+        pool->deques.push_back(std::make_unique<detail::job_deque>());
+    }
+    for (std::size_t i = 0u; i < worker_count; ++i) {
+        pool->workers.emplace_back(&detail::job_pool::work, pool.get(), i);
+    }
+}
+
+inline ion::jobs::~jobs()
+{
+    if (not pool) {
+        return;
+    }
+    pool->stopping = true;
+    pool->epoch.fetch_add(1u);
+    pool->epoch.notify_all();
+    for (auto & worker : pool->workers) {
+        worker.join();
+    }
+    while (run_one()) {
+    }
+}
+
+inline ion::jobs::handle ion::jobs::submit(task job)
+{
+    handle group;
+    submit(std::move(job), group);
+    return group;
+}
+
+inline void ion::jobs::submit(task job, handle & group)
+{
+    group.remaining->fetch_add(1u);
+    pool->push([job = std::move(job), remaining = group.remaining]() mutable {
+        job();
+        if (remaining->fetch_sub(1u) == 1u) {
+            remaining->notify_all();
+        }
+    });
+}
+
+inline bool ion::jobs::run_one()
+{
+    auto const & worker = detail::current_worker;
+    std::size_t const index = worker.pool == pool.get() ? worker.index : 0u;
+    if (auto job = worker.pool == pool.get() ? pool->find(index)
+                                             : pool->steal(index)) {
+        (*job)();
+        return true;
+    }
+    return false;
+}
+
+inline void ion::jobs::wait(handle const & group)
+{
+    bool const is_worker = detail::current_worker.pool == pool.get();
+    while (true) {
+        std::size_t const remaining = group.remaining->load();
+        if (remaining == 0u) {
+            return;
+        }
+        if (run_one()) {
+            continue;
+        }
+        // workers must keep helping, or a pool of waiting workers would stall
+        if (is_worker or pool->workers.empty()) {
+            std::this_thread::yield();
+        }
+        else {
+            group.remaining->wait(remaining);
+        }
+    }
+}
+
+inline std::expected<ion::jobs::handle, std::string>
+ion::jobs::run(ion::job_graph graph)
+{
+    // check the graph is acyclic before starting anything
+    std::vector<std::size_t> dependencies(graph.vertices.size());
+    std::vector<ion::job_graph::node> ready;
+    for (std::size_t i = 0u; i < graph.vertices.size(); ++i) {
+        dependencies[i] = graph.vertices[i].dependencies;
+        if (dependencies[i] == 0u) {
+            ready.push_back(i);
+        }
+    }
+    std::vector<ion::job_graph::node> const roots = ready;
+    std::size_t visited = 0u;
+    while (not ready.empty()) {
+        auto const node = ready.back();
+        ready.pop_back();
+        ++visited;
+        for (auto const successor : graph.vertices[node].successors) {
+            if (--dependencies[successor] == 0u) {
+                ready.push_back(successor);
+            }
+        }
+    }
+    if (visited != graph.vertices.size()) {
+        return std::unexpected("job graph has a cycle");
+    }
+
+    struct graph_run {
+        ion::job_graph graph;
+        std::unique_ptr<std::atomic<std::size_t>[]> pending;
+        ion::jobs * pool;
+        handle group;
+
+        // successors join the group before their predecessor leaves it, so
+        // the group only empties once the whole graph has run
+        static void start(std::shared_ptr<graph_run> const & run,
+                          ion::job_graph::node node)
+        {
+            run->pool->submit([run, node] {
+                auto & vertex = run->graph.vertices[node];
+                vertex.job();
+                for (auto const successor : vertex.successors) {
+                    if (run->pending[successor].fetch_sub(1u) == 1u) {
+                        start(run, successor);
+                    }
+                }
+            }, run->group);
+        }
+    };
+    auto state = std::make_shared<graph_run>();
+    state->pending =
+        std::make_unique<std::atomic<std::size_t>[]>(graph.vertices.size());
+    for (std::size_t i = 0u; i < graph.vertices.size(); ++i) {
+        state->pending[i] = graph.vertices[i].dependencies;
+    }
+    state->graph = std::move(graph);
+    state->pool = this;
+    for (auto const root : roots) {
+        graph_run::start(state, root);
+    }
+    return state->group;
+}
+
+template<std::ranges::random_access_range range, typename function>
+requires std::ranges::sized_range<range> and
+         std::invocable<function &, std::ranges::range_reference_t<range>>
+void ion::jobs::parallel_for(range && values, function fn, std::size_t grain)
+{
+    auto const size = static_cast<std::size_t>(std::ranges::size(values));
+    if (size == 0u) {
+        return;
+    }
+    if (grain == 0u) {
+        // a few jobs per thread, so stealing can even out the work
+        std::size_t const threads = worker_count() + 1u;
+        grain = std::max<std::size_t>(size / (threads * 4u), 1u);
+    }
+    auto const first = std::ranges::begin(values);
+    handle group;
+    for (std::size_t begin = 0u; begin < size; begin += grain) {
+        std::size_t const end = std::min(begin + grain, size);
+        submit([&fn, first, begin, end] {
+            for (std::size_t i = begin; i < end; ++i) {
+                using difference = std::ranges::range_difference_t<range>;
+                std::invoke(fn, first[static_cast<difference>(i)]);
+            }
+        }, group);
+    }
+    wait(group);
+}
+
+inline void ion::jobs::on_main_thread(task job)
+{
+    void (*wake)() = nullptr;
+    {
+        std::scoped_lock const lock{ pool->main_mutex };
+        pool->main_tasks.push_back(std::move(job));
+        wake = pool->wake;
+    }
+    if (wake) {
+        wake();
+    }
+}
+
+inline std::size_t ion::jobs::drain_main_thread()
+{
+    std::vector<task> tasks;
+    {
+        std::scoped_lock const lock{ pool->main_mutex };
+        tasks.swap(pool->main_tasks);
+    }
+    for (auto & job : tasks) {
+        job();
+    }
+    return tasks.size();
+}
+
+inline void ion::jobs::set_wake(void (*wake)())
+{
+    std::scoped_lock const lock{ pool->main_mutex };
+    pool->wake = wake;
+}
+
+inline std::size_t ion::jobs::worker_count() const
+{
+    return pool->workers.size();
+}
+
+inline std::size_t ion::jobs::thread_index() const
+{
+    auto const & worker = detail::current_worker;
+    return worker.pool == pool.get() ? worker.index : worker_count();
+}
+
+inline ion::job_graph::node ion::job_graph::add(ion::jobs::task job)
+{
+    vertices.push_back({ std::move(job), {}, 0u });
+    return vertices.size() - 1u;
+}
+
+inline void ion::job_graph::precede(node before, node after)
+{
+    vertices[before].successors.push_back(after);
+    ++vertices[after].dependencies;
+}
@@ -0,0 +1,308 @@
+#pragma once
+#include "ion/timer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace ion {
+
+/**
+ * \brief Estimates quantiles of a stream of values in fixed memory
+ *
+ * Values are counted in log-linear buckets, as in an HDR histogram: values
+ * below 32 get a bucket each, and each power of two above that is split
+ * into 32 buckets. A quantile is reported as the middle of its bucket, so
+ * it's within about 3% of the true value, whatever the range of the values.
+ *
+ * Sketches merge by adding their buckets, so sketches recorded on separate
+ * threads or over separate intervals can be combined exactly.
+ *
+ * Durations are recorded as nanoseconds.
+ */
+class quantile_sketch {
+public:
+    // the bits of each value kept below its leading bit
+    static constexpr unsigned precision_bits = 5u;
+    static constexpr std::size_t sub_buckets = std::size_t{ 1u } << precision_bits;
+    static constexpr std::size_t bucket_count =
+        (64u - precision_bits + 1u) * sub_buckets;
+
+    /** Count a value `n` times. */
+    void record(std::uint64_t value, std::uint32_t n = 1u);
+
+    /** Count a duration, as nanoseconds; negative durations count as 0. */
+    template<typename rep, typename period>
+    void record(std::chrono::duration<rep, period> value, std::uint32_t n = 1u);
+
+    /** Add every count of another sketch. */
+    void merge(ion::quantile_sketch const & other);
+    void clear();
+
+    [[nodiscard]] inline std::uint64_t count() const { return total; }
+    [[nodiscard]] inline bool empty() const { return total == 0u; }
+    /** The smallest value recorded, exactly, or 0 if empty. */
+    [[nodiscard]] inline std::uint64_t min() const { return empty() ? 0u : smallest; }
+    /** The largest value recorded, exactly, or 0 if empty. */
+    [[nodiscard]] inline std::uint64_t max() const { return largest; }
+    [[nodiscard]] double mean() const;
+
+    /**
+     * \brief Estimate the value that a fraction of values are at or below
+     * \param fraction  e.g. 0.5 for the median, 0.999 for p99.9
+     * \return the estimate, or 0 if the sketch is empty
+     */
+    [[nodiscard]] std::uint64_t quantile(double fraction) const;
+
+    /** Estimate a quantile of recorded durations. */
+    [[nodiscard]] inline std::chrono::nanoseconds
+    duration_quantile(double fraction) const
+    {
+        return std::chrono::nanoseconds{
+            static_cast<std::chrono::nanoseconds::rep>(quantile(fraction)) };
+    }
+
+    [[nodiscard]] static std::size_t bucket_of(std::uint64_t value);
+    /** The smallest value in a bucket. */
+    [[nodiscard]] static std::uint64_t bucket_floor(std::size_t bucket);
+    /** The largest value in a bucket. */
+    [[nodiscard]] static std::uint64_t bucket_ceiling(std::size_t bucket);
+private:
+    std::array<std::uint32_t, bucket_count> buckets{};
+    std::uint64_t total = 0u;
+    std::uint64_t smallest = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t largest = 0u;
+    double sum = 0.0;
+};
+
+/**
+ * \brief Quantiles of the values recorded over the last stretch of time
+ * \tparam clock    the clock that ages out old values
+ *
+ * The window is split into slices, each a quantile_sketch. Recording goes to
+ * the newest slice, and the oldest slice is cleared and reused once the
+ * newest one is a slice long. A snapshot covers between `window - slice`
+ * and `window` of the latest values, in fixed memory.
+ */
+template<timer_clock clock = ion::performance_clock>
+class sliding_quantiles {
+public:
+    using duration = typename clock::duration;
+    using time_point = typename clock::time_point;
+
+    /** Keep the last five seconds of values. */
+    sliding_quantiles();
+    explicit sliding_quantiles(duration window, std::size_t slices = 10u);
+
+    void record(std::uint64_t value, time_point now = clock::now());
+
+    template<typename rep, typename period>
+    void record(std::chrono::duration<rep, period> value,
+                time_point now = clock::now());
+
+    /** Merge the slices still in the window. */
+    [[nodiscard]] ion::quantile_sketch snapshot(time_point now = clock::now()) const;
+
+    [[nodiscard]] inline duration window() const
+    {
+        return slice_length * static_cast<typename duration::rep>(slices.size());
+    }
+private:
+    // move to the slice that `now` falls in, clearing expired slices
+    void advance(time_point now);
+
+    std::vector<ion::quantile_sketch> slices;
+    duration slice_length;
+    std::size_t current = 0u;
+    time_point current_start;
+};
+
+/**
+ * \brief Make a stopwatch callback that records into a sketch
+ *
+ * e.g. `ion::stopwatch const time{ ion::record_to(load_times) };`
+ */
+template<typename sketch>
+auto record_to(sketch & target)
+{
+    return [&target](auto elapsed) { target.record(elapsed); };
+}
+}
+
+inline std::size_t ion::quantile_sketch::bucket_of(std::uint64_t value)
+{
+    if (value < sub_buckets) {
+        return static_cast<std::size_t>(value);
+    }
+    // keep the leading bit and the precision bits below it
+    auto const shift = static_cast<unsigned>(std::bit_width(value)) - 1u
+                     - precision_bits;
+    auto const mantissa = static_cast<std::size_t>(value >> shift);
+    return (shift + 1u) * sub_buckets + (mantissa - sub_buckets);
+}
+
+inline std::uint64_t ion::quantile_sketch::bucket_floor(std::size_t bucket)
+{
+    if (bucket < sub_buckets) {
+        return bucket;
+    }
+    auto const shift = bucket / sub_buckets - 1u;
+    auto const mantissa = std::uint64_t{ sub_buckets + bucket % sub_buckets };
+    return mantissa << shift;
+}
+
+inline std::uint64_t ion::quantile_sketch::bucket_ceiling(std::size_t bucket)
+{
+    if (bucket < sub_buckets) {
+        return bucket;
+    }
+    auto const shift = bucket / sub_buckets - 1u;
+    return bucket_floor(bucket) + ((std::uint64_t{ 1u } << shift) - 1u);
+}
+
+inline void ion::quantile_sketch::record(std::uint64_t value, std::uint32_t n)
+{
+    if (n == 0u) {
+        return;
+    }
+    buckets[bucket_of(value)] += n;
+    total += n;
+    smallest = std::min(smallest, value);
+    largest = std::max(largest, value);
+    sum += static_cast<double>(value) * n;
+}
+
+template<typename rep, typename period>
+inline void ion::quantile_sketch::record(std::chrono::duration<rep, period> value,
+                                         std::uint32_t n)
+{
+    using std::chrono::nanoseconds;
+    auto const ns = std::chrono::duration_cast<nanoseconds>(value).count();
+    record(static_cast<std::uint64_t>(std::max<nanoseconds::rep>(ns, 0)), n);
+}
+
+inline void ion::quantile_sketch::merge(ion::quantile_sketch const & other)
+{
+    for (std::size_t i = 0u; i < bucket_count; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+    smallest = std::min(smallest, other.smallest);
+    largest = std::max(largest, other.largest);
+    sum += other.sum;
+}
+
+inline void ion::quantile_sketch::clear()
+{
+    *this = {};
+}
+
+inline double ion::quantile_sketch::mean() const
+{
+    return empty() ? 0.0 : sum / static_cast<double>(total);
+}
+
+inline std::uint64_t ion::quantile_sketch::quantile(double fraction) const
+{
+    if (empty()) {
+        return 0u;
+    }
+    auto const rank = std::max<std::uint64_t>(
+        static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0)
+                                             * static_cast<double>(total))),
+        1u);
+    // only the buckets between the extremes can hold counts
+    std::size_t const last = bucket_of(largest);
+    std::uint64_t seen = 0u;
+    for (std::size_t bucket = bucket_of(smallest); bucket <= last; ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= rank) {
+            auto const floor = bucket_floor(bucket);
+            auto const middle = floor + (bucket_ceiling(bucket) - floor) / 2u;
+            return std::clamp(middle, smallest, largest);
+        }
+    }
+    return largest;
+}
+
+template<ion::timer_clock clock>
+inline ion::sliding_quantiles<clock>::sliding_quantiles()
+    : sliding_quantiles{ std::chrono::duration_cast<duration>(
+                             std::chrono::seconds{ 5 }) }
+{
+}
+
+template<ion::timer_clock clock>
+inline ion::sliding_quantiles<clock>::sliding_quantiles(duration window,
+                                                        std::size_t slices)
+    : slices(std::max<std::size_t>(slices, 1u)),
+      slice_length{ window / static_cast<typename duration::rep>(
+                        std::max<std::size_t>(slices, 1u)) },
+      current_start{ clock::now() }
+{
+    slice_length = std::max(slice_length, duration{ 1 });
+}
+
+template<ion::timer_clock clock>
+inline void ion::sliding_quantiles<clock>::advance(time_point now)
+{
+    if (now - current_start < slice_length) {
+        return;
+    }
+    if (now - current_start >= window()) {
+        // everything has expired
+        for (auto & slice : slices) {
+            slice.clear();
+        }
+        current_start = now;
+        return;
+    }
+    while (now - current_start >= slice_length) {
+        current = (current + 1u) % slices.size();
+        slices[current].clear();
+        current_start += slice_length;
+    }
+}
+
+template<ion::timer_clock clock>
+inline void ion::sliding_quantiles<clock>::record(std::uint64_t value,
+                                                  time_point now)
+{
+    advance(now);
+    slices[current].record(value);
+}
+
+template<ion::timer_clock clock>
+template<typename rep, typename period>
+inline void
+ion::sliding_quantiles<clock>::record(std::chrono::duration<rep, period> value,
+                                      time_point now)
+{
+    advance(now);
+    slices[current].record(value);
+}
+
+template<ion::timer_clock clock>
+inline ion::quantile_sketch
+ion::sliding_quantiles<clock>::snapshot(time_point now) const
+{
+    ion::quantile_sketch merged;
+    for (std::size_t age = 0u; age < slices.size(); ++age) {
+        // the slice `age` slices before the newest one ends when the slice
+        // after it starts
+        auto const end = current_start + slice_length
+                       - slice_length * static_cast<typename duration::rep>(age);
+        if (now - end > window() - slice_length) {
+            break;
+        }
+        merged.merge(slices[(current + slices.size() - age) % slices.size()]);
+    }
+    return merged;
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include "ion/jobs.hpp"
+
+#include <entt/entity/registry.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ion {
+
+/** When in each iteration of the main loop a scheduled task runs */
+enum class phase : std::uint8_t {
+    pre_update,  /** after events, before fixed updates */
+    post_update, /** after fixed updates, before rendering */
+    render       /** while imgui builds a frame, always on the main thread */
+};
+
+/**
+ * \brief Runs subsystem work each frame, in parallel where it's safe to
+ *
+ * Tasks declare the phase they run in and the resources they read or write.
+ * Each time a phase runs, the scheduler builds a graph where a task waits for
+ * every earlier task of the phase that it conflicts with: one writes what
+ * the other reads or writes. Tasks that don't conflict run at the same time
+ * on an ion::jobs pool, and tasks pinned to the main thread, such as imgui
+ * calls, run on the thread that runs the phase.
+ *
+ * Register the scheduler with `system.add_subsystem<ion::scheduler>()`, and
+ * the main loop runs its phases.
+ */
+class scheduler {
+public:
+    using task = std::move_only_function<void()>;
+
+    /** Declares what a task accesses, after adding it */
+    class builder {
+    public:
+        template<typename... resources>
+        builder & reads();
+        template<typename... resources>
+        builder & writes();
+
+        builder & reads(entt::id_type resource);
+        builder & writes(entt::id_type resource);
+
+        /** Always run the task on the main thread. */
+        builder & main_thread();
+    private:
+        friend class scheduler;
+        builder(ion::scheduler & owner, std::size_t index);
+        ion::scheduler * owner;
+        std::size_t index;
+    };
+
+    /**
+     * \brief Add a task
+     *
+     * \param name  identifies the task, e.g. to disable it
+     * \param when  the phase the task runs in
+     * \param job   the work to run once per phase
+     *
+     * Tasks of a phase that conflict run in the order they were added.
+     */
+    builder add(std::string name, ion::phase when, task job);
+
+    /** Skip or resume running a task. */
+    void set_enabled(std::string_view name, bool enabled);
+
+    /**
+     * \brief Run every enabled task of a phase, and wait for them to finish
+     * \param pool  runs tasks that can run concurrently, or null to run
+     *              every task on this thread
+     */
+    void run(ion::phase when, ion::jobs * pool = nullptr);
+
+    [[nodiscard]] inline std::size_t size() const { return entries.size(); }
+private:
+    struct entry {
+        std::string name;
+        ion::phase when;
+        task job;
+        std::vector<entt::id_type> reads;
+        std::vector<entt::id_type> writes;
+        bool main_thread = false;
+        bool enabled = true;
+    };
+    [[nodiscard]] static bool conflicts(entry const & first,
+                                        entry const & second);
+    void release(std::size_t node, ion::jobs & pool);
+    void finish(std::size_t node, ion::jobs & pool);
+
+    std::vector<entry> entries;
+
+    // the graph of the running phase, kept between frames to reuse memory
+    std::vector<std::size_t> order;
+    std::vector<std::vector<std::size_t>> successors;
+    std::vector<std::size_t> dependencies;
+
+    // shared with workers while a phase runs, and kept apart so the
+    // scheduler stays movable
+    struct run_state {
+        std::unique_ptr<std::atomic<std::size_t>[]> pending;
+        std::size_t pending_size = 0u;
+
+        // guards the tasks left to finish and the main thread tasks ready
+        std::mutex mutex;
+        std::size_t remaining = 0u;
+        std::condition_variable ready;
+        std::vector<std::size_t> main_ready;
+    };
+    std::unique_ptr<run_state> state = std::make_unique<run_state>();
+};
+}
+
+inline ion::scheduler::builder::builder(ion::scheduler & owner,
+                                        std::size_t index)
+    : owner{ &owner }, index{ index }
+{
+}
+
+template<typename... resources>
+inline ion::scheduler::builder & ion::scheduler::builder::reads()
+{
+    (reads(entt::type_hash<resources>::value()), ...);
+    return *this;
+}
+
+template<typename... resources>
+inline ion::scheduler::builder & ion::scheduler::builder::writes()
+{
+    (writes(entt::type_hash<resources>::value()), ...);
+    return *this;
+}
+
+inline ion::scheduler::builder &
+ion::scheduler::builder::reads(entt::id_type resource)
+{
+    owner->entries[index].reads.push_back(resource);
+    return *this;
+}
+
+inline ion::scheduler::builder &
+ion::scheduler::builder::writes(entt::id_type resource)
+{
+    owner->entries[index].writes.push_back(resource);
+    return *this;
+}
+
+inline ion::scheduler::builder & ion::scheduler::builder::main_thread()
+{
+    owner->entries[index].main_thread = true;
+    return *this;
+}
+
+inline ion::scheduler::builder
+ion::scheduler::add(std::string name, ion::phase when, task job)
+{
+    entries.push_back({ std::move(name), when, std::move(job), {}, {} });
+    return builder{ *this, entries.size() - 1u };
+}
+
+inline void ion::scheduler::set_enabled(std::string_view name, bool enabled)
+{
+    for (auto & entry : entries) {
+        if (entry.name == name) {
+            entry.enabled = enabled;
+        }
+    }
+}
+
+inline bool ion::scheduler::conflicts(entry const & first,
+                                      entry const & second)
+{
+    auto const contains = [](auto const & resources, entt::id_type resource) {
+        return std::ranges::find(resources, resource) != resources.end();
+    };
+    for (auto const resource : first.writes) {
+        if (contains(second.reads, resource) or
+            contains(second.writes, resource)) {
+            return true;
+        }
+    }
+    for (auto const resource : first.reads) {
+        if (contains(second.writes, resource)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void ion::scheduler::run(ion::phase when, ion::jobs * pool)
+{
+    order.clear();
+    for (std::size_t i = 0u; i < entries.size(); ++i) {
+        if (entries[i].when == when and entries[i].enabled) {
+            order.push_back(i);
+        }
+    }
+    // the order tasks were added in already satisfies every dependency
+    bool const parallel = pool and pool->worker_count() > 0u
+                               and when != ion::phase::render
+                               and order.size() > 1u;
+    if (not parallel) {
+        for (auto const i : order) {
+            entries[i].job();
+        }
+        return;
+    }
+
+    std::size_t const size = order.size();
+    if (successors.size() < size) {
+        successors.resize(size);
+    }
+    dependencies.assign(size, 0u);
+    for (std::size_t later = 0u; later < size; ++later) {
+        successors[later].clear();
+        for (std::size_t earlier = 0u; earlier < later; ++earlier) {
+            if (conflicts(entries[order[earlier]], entries[order[later]])) {
+                successors[earlier].push_back(later);
+                ++dependencies[later];
+            }
+        }
+    }
+    auto & [pending, pending_size, mutex, remaining, ready, main_ready] = *state;
+    if (pending_size < size) {
+        pending = std::make_unique<std::atomic<std::size_t>[]>(size);
+        pending_size = size;
+    }
+    for (std::size_t node = 0u; node < size; ++node) {
+        pending[node] = dependencies[node];
+    }
+    remaining = size;
+    for (std::size_t node = 0u; node < size; ++node) {
+        if (dependencies[node] == 0u) {
+            release(node, *pool);
+        }
+    }
+
+    // run main thread tasks as they become ready, until every task is done
+    std::unique_lock lock{ mutex };
+    while (true) {
+        ready.wait(lock, [&main_ready, &remaining] {
+            return not main_ready.empty() or remaining == 0u;
+        });
+        if (main_ready.empty()) {
+            break;
+        }
+        auto const node = main_ready.back();
+        main_ready.pop_back();
+        lock.unlock();
+        entries[order[node]].job();
+        finish(node, *pool);
+        lock.lock();
+    }
+}
+
+inline void ion::scheduler::release(std::size_t node, ion::jobs & pool)
+{
+    if (entries[order[node]].main_thread) {
+        {
+            std::scoped_lock const lock{ state->mutex };
+            state->main_ready.push_back(node);
+        }
+        state->ready.notify_one();
+        return;
+    }
+    pool.submit([this, node, &pool] {
+        entries[order[node]].job();
+        finish(node, pool);
+    });
+}
+
+inline void ion::scheduler::finish(std::size_t node, ion::jobs & pool)
+{
+    for (auto const successor : successors[node]) {
+        if (state->pending[successor].fetch_sub(1u) == 1u) {
+            release(successor, pool);
+        }
+    }
+    // the main thread may return as soon as it sees the last task finish,
+    // so nothing can touch the state after unlocking
+    std::scoped_lock const lock{ state->mutex };
+    if (--state->remaining == 0u) {
+        state->ready.notify_one();
+    }
+}
@@ -4,6 +4,12 @@
 #include "glad/glad.h"
 #include "imgui/backends/imgui_impl_sdl.h"
 #include "imgui/backends/imgui_impl_opengl3.h"
+#include "ion/font_cache.hpp"
+#include "ion/input_record.hpp"
+#include "ion/jobs.hpp"
+#include "ion/quantile.hpp"
+#include "ion/scheduler.hpp"
+#include "ion/timer.hpp"
 #include "ion/try.hpp"
 
 // frameworks
@@ -21,16 +27,84 @@
 #include <regex>
 
 // events
+#include <array>
 #include <vector>
 #include <functional>
+#include <cstdint>
+#include <future>
+#include <memory>
 
 #include <ranges>
 #include <algorithm>
+#include <cmath>
 
 namespace ion {
 
+class system;
+
+namespace detail {
+struct main_loop;
+}
+
+/**
+ * \brief Run the main loop.
+ *
+ * In idle mode, the loop waits for events instead of rendering continuously
+ * once the ui has settled, rendering at least once every max frame interval.
+ *
+ * When replaying input, the loop runs each recorded frame in turn with the
+ * recorded fixed updates, writes the frame timings and returns.
+ *
+ * If an ion::jobs subsystem is registered, its main thread queue is drained
+ * once per iteration. If an ion::scheduler subsystem is registered, its
+ * phases run around the fixed updates and while building each frame, in
+ * parallel on the jobs subsystem if there is one.
+ */
+void run(ion::system & system);
+
+/** Wake the main loop to render a frame, from any thread. */
+void request_redraw();
+
+/**
+ * \brief Shut down imgui, the window and SDL before a system is destroyed
+ *
+ * The library's destructor shuts down the OpenGL3 renderer, which a headless
+ * system never initialized, so headless systems have to be shut down here.
+ * ion::run does so once a headless system's loop ends. Shutting down any
+ * other system is the same as destroying it, and the destructor then skips
+ * the teardown.
+ */
+void shutdown(ion::system & system);
+
 using flagmap = std::unordered_map<std::string, std::uint32_t>;
 
+/** An SDL flag and the name it's configured by */
+using flag_name = konbu::flag_name<std::uint32_t>;
+
+namespace detail {
+/** Look up the flags of a constexpr table of flag names by name */
+template<std::size_t size>
+flagmap to_flagmap(std::array<ion::flag_name, size> const & table)
+{
+    flagmap result;
+    result.reserve(size);
+    for (auto const & flag : table) {
+        result.emplace(flag.name, flag.value);
+    }
+    return result;
+}
+}
+
+/**
+ * \brief SDL, a window, an OpenGL context and ImGui, with their subsystems
+ *
+ * \warning A headless system (init_params::headless) has to be shut down
+ *          with ion::run or ion::shutdown before it's destroyed. The
+ *          library's destructor shuts down the OpenGL3 renderer, which a
+ *          headless system never initialized, and can't be changed to
+ *          know better; neither can the system's layout, so there's no
+ *          room to register the teardown elsewhere.
+ */
 class system {
 public:
     system() = delete;
@@ -56,10 +130,15 @@ public:
      *         relevant SDL_Error.
      *
      * "Various system settings" include settings for:
-     * - system -> ion::init_params     how to initialize SDL
+     * - system -> ion::init_params     how to initialize SDL, or headless
      * - window -> ion::window_params   how to create the window
      * - opengl -> ion::opengl_params   how to initialize OpenGL
      * - imgui -> ion::imgui_params     how to initialize ImGui
+     * - input -> ion::input_params     whether to record or replay input
+     *
+     * The font atlas is built on a worker thread while SDL, the window and
+     * the OpenGL context initialize. Assets the first frame needs can be
+     * loaded the same way by starting them before calling from_config.
      */
     template<std::ranges::output_range<YAML::Exception> error_output>
     [[nodiscard]] static std::expected<system, std::string>
@@ -85,7 +164,11 @@ public:
     // Logic
     //
 
-    /** Run the main loop. */
+    /**
+     * \brief Run the library's main loop.
+     * \note ion::run drives the idle mode, fixed updates, scheduler, input
+     *       replay and frame statistics, which this loop doesn't know about.
+     */
     void start();
 
     //
@@ -113,6 +196,18 @@ public:
     [[nodiscard]] inline auto on_render() { return entt::sink{ render_event }; }
     [[nodiscard]] inline auto on_keydown() { return entt::sink{ keydown_event }; }
 
+    /** Called at a fixed rate with the time step in seconds. */
+    [[nodiscard]] auto on_update();
+
+    /** Called once the first frame is shown, with the startup timings. */
+    [[nodiscard]] auto on_first_frame();
+
+    /**
+     * \brief How far rendering is between the last update and the next one
+     * \return a value in [0, 1) to interpolate rendered state with
+     */
+    [[nodiscard]] double interpolation() const;
+
     //
     // Utility
     //
@@ -125,6 +220,7 @@ public:
     [[nodiscard]] inline SDL_Window * window() { return _window; }
     [[nodiscard]] inline SDL_Window const * window() const { return _window; }
 
+    /** The OpenGL context, or null for a headless system. */
     [[nodiscard]] inline void * gl_context() { return _gl_context; }
     [[nodiscard]] inline void const * gl_context() const { return _gl_context; }
     [[nodiscard]] inline entt::entity id() const { return _id; }
@@ -132,6 +228,10 @@ private:
     system(SDL_Window * window, SDL_GLContext gl_context);
     bool moved = false;
 
+    // the main loop is defined outside of the class, so it can't collide
+    // with the library's definitions of system's members
+    friend struct detail::main_loop;
+
     // events
     entt::sigh<void(SDL_Window *)> render_event;
     entt::sigh<void(SDL_Keysym const &)> keydown_event;
@@ -143,8 +243,17 @@ private:
 
 struct init_params {
     std::uint32_t subsystems = SDL_INIT_VIDEO;
-
-    inline static flagmap const subsystem_flags{
+    // run without a visible window or OpenGL, e.g. for benchmarks and tests.
+    // A headless system MUST be passed to ion::run or ion::shutdown before
+    // it's destroyed, see ion::system.
+    bool headless = false;
+    // the SDL video driver to use, or empty for SDL's choice. Headless
+    // systems try the offscreen driver, then the dummy driver.
+    std::string video_driver;
+
+    // the flag names, which konbu::read_flags reads without allocating
+    inline static constexpr auto subsystem_flag_names =
+        std::to_array<ion::flag_name>({
         { "timer",              SDL_INIT_TIMER },
         { "audio",              SDL_INIT_AUDIO },
         { "video",              SDL_INIT_VIDEO },
@@ -153,7 +262,11 @@ struct init_params {
         { "game-controller",    SDL_INIT_GAMECONTROLLER },
         { "events",             SDL_INIT_EVENTS },
         { "everything",         SDL_INIT_EVERYTHING }
-    };
+    });
+
+    // the same flags by name, for encoding them
+    inline static flagmap const subsystem_flags =
+        detail::to_flagmap(subsystem_flag_names);
 };
 
 struct window_params {
@@ -164,7 +277,9 @@ struct window_params {
     std::uint16_t height = 480u;
     std::uint32_t flags = 0u;
 
-    inline static flagmap const window_flags{
+    // the flag names, which konbu::read_flags reads without allocating
+    inline static constexpr auto window_flag_names =
+        std::to_array<ion::flag_name>({
         { "fullscreen",         SDL_WINDOW_FULLSCREEN },
         { "fullscreen-desktop", SDL_WINDOW_FULLSCREEN_DESKTOP },
         { "opengl",             SDL_WINDOW_OPENGL },
@@ -177,7 +292,11 @@ struct window_params {
         { "maximized",          SDL_WINDOW_MAXIMIZED },
         { "input-grabbed",      SDL_WINDOW_INPUT_GRABBED },
         { "allow-high-dpi",     SDL_WINDOW_ALLOW_HIGHDPI },
-    };
+    });
+
+    // the same flags by name, for encoding them
+    inline static flagmap const window_flags =
+        detail::to_flagmap(window_flag_names);
 };
 
 struct opengl_params{
@@ -189,16 +308,150 @@ struct opengl_params{
     std::uint16_t major_version = 4;
     std::uint16_t minor_version = 2;
 
-    inline static flagmap const opengl_flags{
+    // the flag names, which konbu::read_flags reads without allocating
+    inline static constexpr auto opengl_flag_names =
+        std::to_array<ion::flag_name>({
         { "debug",              SDL_GL_CONTEXT_DEBUG_FLAG },
         { "forward-compatible", SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG },
         { "robust-access",      SDL_GL_CONTEXT_ROBUST_ACCESS_FLAG },
         { "reset-isolation",    SDL_GL_CONTEXT_RESET_ISOLATION_FLAG }
+    });
+
+    // the same flags by name, for encoding them
+    inline static flagmap const opengl_flags =
+        detail::to_flagmap(opengl_flag_names);
+};
+
+enum class glyph_ranges {
+    default_ranges,
+    greek,
+    korean,
+    japanese,
+    chinese_full,
+    chinese_simplified_common,
+    cyrillic,
+    thai,
+    vietnamese
+};
+
+struct font_params {
+    std::filesystem::path path;
+    float size = 13.f;
+    ion::glyph_ranges glyphs = ion::glyph_ranges::default_ranges;
+
+    inline static std::unordered_map<std::string, ion::glyph_ranges> const
+    glyph_range_names{
+        { "default",                   ion::glyph_ranges::default_ranges },
+        { "greek",                     ion::glyph_ranges::greek },
+        { "korean",                    ion::glyph_ranges::korean },
+        { "japanese",                  ion::glyph_ranges::japanese },
+        { "chinese-full",              ion::glyph_ranges::chinese_full },
+        { "chinese-simplified-common",
+          ion::glyph_ranges::chinese_simplified_common },
+        { "cyrillic",                  ion::glyph_ranges::cyrillic },
+        { "thai",                      ion::glyph_ranges::thai },
+        { "vietnamese",                ion::glyph_ranges::vietnamese }
     };
 };
 
 struct imgui_params{
     std::string glsl_version = "#version 150";
+    // imgui's default font is used when no fonts are given
+    std::vector<ion::font_params> fonts;
+    // where built font atlases are cached, or empty to always rasterize
+    std::filesystem::path font_cache;
+};
+
+/** Owns the font atlas shared with the imgui context */
+struct font_atlas {
+    std::unique_ptr<ImFontAtlas> atlas;
+    // whether the atlas was loaded from the font cache
+    bool cached = false;
+};
+
+/** How long each part of starting up took */
+struct startup_timings {
+    using duration = ion::performance_clock::duration;
+
+    ion::performance_timer timer;
+    // from_config, from the start of initializing SDL until it returned
+    duration initialized{};
+    // building the font atlas on a worker thread, overlapped with init
+    duration fonts{};
+    bool fonts_cached = false;
+    // from the start of initializing SDL until the first frame was swapped
+    duration first_frame{};
+    bool reported = false;
+    entt::sigh<void(ion::startup_timings const &)> first_frame_event;
+};
+
+/**
+ * \brief How long the recent frames of the main loop took
+ *
+ * Add it with `system.add_subsystem<ion::frame_statistics>()`, and the main
+ * loop records each iteration into it.
+ */
+struct frame_statistics {
+    // between one rendered frame and the next
+    ion::sliding_quantiles<> frame;
+    // handling events and running updates, each iteration
+    ion::sliding_quantiles<> update;
+    // building and drawing a frame
+    ion::sliding_quantiles<> render;
+};
+
+struct loop_params {
+    // wait for events instead of rendering continuously
+    bool idle = false;
+    // the longest time in milliseconds to wait between frames when idle
+    std::uint32_t max_frame_interval = 500u;
+};
+
+struct input_params {
+    // record input to this file, if set
+    std::filesystem::path record;
+    // replay input from this file instead of reading it, if set
+    std::filesystem::path replay;
+    // write per-frame timings of a replay to this csv file, if set
+    std::filesystem::path timings;
+};
+
+struct update_params {
+    // the number of updates per second
+    double rate = 60.0;
+    // the most updates to catch up on in one frame
+    std::uint32_t max_steps = 5u;
+};
+
+/**
+ * \brief Drives the update signal at a fixed rate, separate from rendering
+ *
+ * Elapsed frame time is accumulated and spent in whole time steps, so the
+ * cost of updating doesn't change with the frame rate.
+ */
+struct fixed_update {
+    ion::update_params params;
+    entt::sigh<void(double)> update_event;
+    double accumulator = 0.0;
+
+    /** The time step of each update in seconds. */
+    [[nodiscard]] inline double step() const { return 1.0 / params.rate; }
+
+    /** The fraction of a time step left in the accumulator. */
+    [[nodiscard]] inline double alpha() const { return accumulator / step(); }
+
+    /** The seconds until the next update is due. */
+    [[nodiscard]] inline double time_until_update() const
+    {
+        return step() - accumulator;
+    }
+
+    /**
+     * \brief Run every update due after some time has passed
+     * \param elapsed  seconds since the last call
+     * \return the number of updates run
+     */
+    std::uint32_t advance(double elapsed);
 };
 
 template<class subsystem>
@@ -253,11 +506,27 @@ void read(YAML::Node const & config,
         std::vector<YAML::Exception> subsystem_errors;
 
         read_flags(subsystem_config, params.subsystems,
-                   param::subsystem_flags, subsystem_errors);
+                   param::subsystem_flag_names, subsystem_errors);
         ranges::transform(subsystem_errors,
                           konbu::back_inserter_preference(errors),
                           konbu::contextualize_setting("subsystem"));
     }
+    if (auto const headless_config = config["headless"]) {
+        std::vector<YAML::Exception> headless_errors;
+        konbu::read(headless_config, params.headless, headless_errors);
+        ranges::transform(headless_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("headless",
+                                                     params.headless));
+    }
+    if (auto const driver_config = config["video-driver"]) {
+        std::vector<YAML::Exception> driver_errors;
+        konbu::read(driver_config, params.video_driver, driver_errors);
+        ranges::transform(driver_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("video-driver",
+                                                     params.video_driver));
+    }
 }
 
 template<std::ranges::output_range<YAML::Exception> error_output>
@@ -314,7 +583,8 @@ void read(YAML::Node const & config,
     }
     if (auto const flag_sequence = config["flags"]) {
         konbu::read_flags(flag_sequence, params.flags,
-                          ion::window_params::window_flags, window_errors);
+                          ion::window_params::window_flag_names,
+                          window_errors);
         ranges::transform(window_errors,
                           konbu::back_inserter_preference(errors),
                           konbu::contextualize_param("flags", params.flags));
@@ -386,19 +656,83 @@ void read(YAML::Node const & config,
     if (auto const flag_sequence = config["flags"]) {
         std::vector<YAML::Exception> flag_errors;
         konbu::read_flags(flag_sequence, params.flags,
-                          ion::opengl_params::opengl_flags, flag_errors);
+                          ion::opengl_params::opengl_flag_names,
+                          flag_errors);
         ranges::transform(flag_errors,
                           konbu::back_inserter_preference(errors),
                           konbu::contextualize_param("flags", params.flags));
     }
 }
 
+/**
+ * \brief Read a font as either its path, or a map of its path and size
+ */
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config,
+          ion::font_params & params,
+          error_output & errors)
+{
+    namespace ranges = std::ranges;
+    namespace views = std::views;
+
+    if (config.IsScalar()) {
+        konbu::read(config, params.path, errors);
+        return;
+    }
+    if (not config.IsMap()) {
+        YAML::Exception const error{ config.Mark(),
+                                     "expecting a font path or a map" };
+        ranges::copy(views::single(error),
+                     konbu::back_inserter_preference(errors));
+        return;
+    }
+    if (auto const path_config = config["path"]) {
+        std::vector<YAML::Exception> path_errors;
+        konbu::read(path_config, params.path, path_errors);
+        ranges::transform(path_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("path",
+                                                     params.path.string()));
+    }
+    else {
+        YAML::Exception const error{ config.Mark(), "expecting a font path" };
+        ranges::copy(views::single(error),
+                     konbu::back_inserter_preference(errors));
+    }
+    if (auto const size_config = config["size"]) {
+        std::vector<YAML::Exception> size_errors;
+        float size = params.size;
+        konbu::read(size_config, size, size_errors);
+        if (size_errors.empty() and size <= 0.f) {
+            size_errors.emplace_back(size_config.Mark(),
+                                     "expecting a positive size");
+        }
+        else if (size_errors.empty()) {
+            params.size = size;
+        }
+        ranges::transform(size_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("size", params.size));
+    }
+    if (auto const glyphs_config = config["glyphs"]) {
+        std::vector<YAML::Exception> glyph_errors;
+        konbu::read_lookup(glyphs_config, params.glyphs,
+                           ion::font_params::glyph_range_names, glyph_errors);
+        ranges::transform(glyph_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("glyphs",
+                                                     glyphs_config.Scalar()));
+    }
+}
+
 template<std::ranges::output_range<YAML::Exception> error_output>
 void read(YAML::Node const & config,
           ion::imgui_params & params,
           error_output & errors)
 {
     namespace ranges = std::ranges;
+    namespace views = std::views;
+
     if (auto const glsl_config = config["glsl"]) {
         std::vector<YAML::Exception> glsl_errors;
         konbu::read(glsl_config, params.glsl_version, glsl_errors);
@@ -407,6 +741,162 @@ void read(YAML::Node const & config,
                           konbu::contextualize_param("glsl",
                                                      params.glsl_version));
     }
+    if (auto const cache_config = config["font-cache"]) {
+        std::vector<YAML::Exception> cache_errors;
+        konbu::read(cache_config, params.font_cache, cache_errors);
+        ranges::transform(cache_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param(
+                              "font-cache", params.font_cache.string()));
+    }
+    if (auto const fonts_config = config["fonts"]) {
+        if (not fonts_config.IsSequence()) {
+            YAML::Exception const error{ fonts_config.Mark(),
+                                         "couldn't read fonts: "
+                                         "expecting a sequence" };
+            ranges::copy(views::single(error),
+                         konbu::back_inserter_preference(errors));
+            return;
+        }
+        std::vector<YAML::Exception> font_errors;
+        for (auto const & font_config : fonts_config) {
+            ion::font_params font;
+            std::size_t const error_count = font_errors.size();
+            konbu::read(font_config, font, font_errors);
+            if (font_errors.size() == error_count) {
+                params.fonts.push_back(std::move(font));
+            }
+        }
+        ranges::transform(font_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_setting("fonts"));
+    }
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config,
+          ion::loop_params & params,
+          error_output & errors)
+{
+    namespace ranges = std::ranges;
+    namespace views = std::views;
+
+    if (not config.IsMap()) {
+        YAML::Exception const error{ config.Mark(), "expecting a map" };
+        ranges::copy(views::single(error),
+                     konbu::back_inserter_preference(errors));
+        return;
+    }
+    if (auto const idle_config = config["idle"]) {
+        std::vector<YAML::Exception> idle_errors;
+        konbu::read(idle_config, params.idle, idle_errors);
+        ranges::transform(idle_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("idle", params.idle));
+    }
+    if (auto const interval_config = config["max-frame-interval"]) {
+        std::vector<YAML::Exception> interval_errors;
+        konbu::read(interval_config, params.max_frame_interval,
+                    interval_errors);
+        ranges::transform(interval_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param(
+                              "max-frame-interval",
+                              params.max_frame_interval));
+    }
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config,
+          ion::input_params & params,
+          error_output & errors)
+{
+    namespace ranges = std::ranges;
+    namespace views = std::views;
+
+    if (not config.IsMap()) {
+        YAML::Exception const error{ config.Mark(), "expecting a map" };
+        ranges::copy(views::single(error),
+                     konbu::back_inserter_preference(errors));
+        return;
+    }
+    if (auto const record_config = config["record"]) {
+        std::vector<YAML::Exception> record_errors;
+        konbu::read(record_config, params.record, record_errors);
+        ranges::transform(record_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("record",
+                                                     params.record.string()));
+    }
+    if (auto const replay_config = config["replay"]) {
+        std::vector<YAML::Exception> replay_errors;
+        konbu::read(replay_config, params.replay, replay_errors);
+        if (replay_errors.empty() and not params.record.empty()) {
+            replay_errors.emplace_back(replay_config.Mark(),
+                                       "can't record while replaying");
+            params.record.clear();
+        }
+        ranges::transform(replay_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("replay",
+                                                     params.replay.string()));
+    }
+    if (auto const timings_config = config["timings"]) {
+        std::vector<YAML::Exception> timings_errors;
+        konbu::read(timings_config, params.timings, timings_errors);
+        ranges::transform(timings_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("timings",
+                                                     params.timings.string()));
+    }
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config,
+          ion::update_params & params,
+          error_output & errors)
+{
+    namespace ranges = std::ranges;
+    namespace views = std::views;
+
+    if (not config.IsMap()) {
+        YAML::Exception const error{ config.Mark(), "expecting a map" };
+        ranges::copy(views::single(error),
+                     konbu::back_inserter_preference(errors));
+        return;
+    }
+    if (auto const rate_config = config["rate"]) {
+        std::vector<YAML::Exception> rate_errors;
+        double rate = params.rate;
+        konbu::read(rate_config, rate, rate_errors);
+        if (rate_errors.empty() and rate <= 0.0) {
+            rate_errors.emplace_back(rate_config.Mark(),
+                                     "expecting a positive rate");
+        }
+        else if (rate_errors.empty()) {
+            params.rate = rate;
+        }
+        ranges::transform(rate_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("rate", params.rate));
+    }
+    if (auto const steps_config = config["max-steps"]) {
+        std::vector<YAML::Exception> steps_errors;
+        std::uint32_t max_steps = params.max_steps;
+        konbu::read(steps_config, max_steps, steps_errors);
+        // without a step, the loop would never publish an update
+        if (steps_errors.empty() and max_steps < 1u) {
+            steps_errors.emplace_back(steps_config.Mark(),
+                                      "expecting at least one step");
+        }
+        else if (steps_errors.empty()) {
+            params.max_steps = max_steps;
+        }
+        ranges::transform(steps_errors,
+                          konbu::back_inserter_preference(errors),
+                          konbu::contextualize_param("max-steps",
+                                                     params.max_steps));
+    }
 }
 }
 
@@ -441,6 +931,12 @@ struct convert<ion::init_params> {
         Node node;
         encode_flags(node, "subsystems", rhs.subsystems,
                      ion::init_params::subsystem_flags);
+        if (rhs.headless) {
+            node["headless"] = rhs.headless;
+        }
+        if (not rhs.video_driver.empty()) {
+            node["video-driver"] = rhs.video_driver;
+        }
         return node;
     }
 };
@@ -501,6 +997,62 @@ struct convert<ion::imgui_params> {
     {
         Node node;
         node["glsl-version"] = rhs.glsl_version;
+        if (not rhs.font_cache.empty()) {
+            node["font-cache"] = rhs.font_cache.string();
+        }
+        for (auto const & [path, size, glyphs] : rhs.fonts) {
+            Node font;
+            font["path"] = path.string();
+            font["size"] = size;
+            for (auto const & [name, value] :
+                 ion::font_params::glyph_range_names) {
+                if (value == glyphs and
+                    glyphs != ion::glyph_ranges::default_ranges) {
+                    font["glyphs"] = name;
+                }
+            }
+            node["fonts"].push_back(font);
+        }
+        return node;
+    }
+};
+
+template<>
+struct convert<ion::update_params> {
+    static Node encode(ion::update_params const & rhs)
+    {
+        Node node;
+        node["rate"] = rhs.rate;
+        node["max-steps"] = rhs.max_steps;
+        return node;
+    }
+};
+
+template<>
+struct convert<ion::input_params> {
+    static Node encode(ion::input_params const & rhs)
+    {
+        Node node;
+        if (not rhs.record.empty()) {
+            node["record"] = rhs.record.string();
+        }
+        if (not rhs.replay.empty()) {
+            node["replay"] = rhs.replay.string();
+        }
+        if (not rhs.timings.empty()) {
+            node["timings"] = rhs.timings.string();
+        }
+        return node;
+    }
+};
+
+template<>
+struct convert<ion::loop_params> {
+    static Node encode(ion::loop_params const & rhs)
+    {
+        Node node;
+        node["idle"] = rhs.idle;
+        node["max-frame-interval"] = rhs.max_frame_interval;
         return node;
     }
 };
@@ -523,6 +1075,17 @@ inline void cleanup(SDL_Window * window,
 inline std::expected<void, std::string>
 init_sdl(const init_params& params)
 {
+    if (not params.video_driver.empty()) {
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, params.video_driver.c_str());
+    }
+    else if (params.headless) {
+        // the offscreen driver needs SDL 2.0.22, dummy works everywhere
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+        if (SDL_Init(params.subsystems) == 0) {
+            return {};
+        }
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    }
     if (SDL_Init(params.subsystems) != 0) {
         return std::unexpected(SDL_GetError());
     }
@@ -530,13 +1093,13 @@ init_sdl(const init_params& params)
 }
 
 inline std::expected<SDL_Window*, std::string>
-load_window(const window_params& params)
+load_window(const window_params& params, bool headless)
 {
     auto const &[name, x, y, width, height, _] = params;
 
-    // window _must_ be opengl
-    std::uint32_t const flags = params.flags
-                              | SDL_WINDOW_OPENGL;
+    // window _must_ be opengl, unless there's no opengl at all
+    std::uint32_t const flags = headless ? params.flags | SDL_WINDOW_HIDDEN
+                                         : params.flags | SDL_WINDOW_OPENGL;
 
     SDL_Window * window = SDL_CreateWindow(name.c_str(), x, y,
                                            width, height, flags);
@@ -570,18 +1133,111 @@ load_opengl(const opengl_params& gl, SDL_Window* window)
     return gl_context;
 }
 
+inline ImWchar const * find_glyph_ranges(ImFontAtlas & atlas,
+                                         ion::glyph_ranges glyphs)
+{
+    switch (glyphs) {
+    case ion::glyph_ranges::greek:
+        return atlas.GetGlyphRangesGreek();
+    case ion::glyph_ranges::korean:
+        return atlas.GetGlyphRangesKorean();
+    case ion::glyph_ranges::japanese:
+        return atlas.GetGlyphRangesJapanese();
+    case ion::glyph_ranges::chinese_full:
+        return atlas.GetGlyphRangesChineseFull();
+    case ion::glyph_ranges::chinese_simplified_common:
+        return atlas.GetGlyphRangesChineseSimplifiedCommon();
+    case ion::glyph_ranges::cyrillic:
+        return atlas.GetGlyphRangesCyrillic();
+    case ion::glyph_ranges::thai:
+        return atlas.GetGlyphRangesThai();
+    case ion::glyph_ranges::vietnamese:
+        return atlas.GetGlyphRangesVietnamese();
+    default:
+        return atlas.GetGlyphRangesDefault();
+    }
+}
+
+/**
+ * \brief Rasterize fonts into an atlas, without an imgui context
+ *
+ * Safe to run on a worker thread as long as no imgui context exists yet.
+ * When a cache directory is given, an atlas cached with the same fonts is
+ * loaded instead of rasterized, and a newly built atlas is cached.
+ */
+inline std::expected<ion::font_atlas, std::string>
+build_font_atlas(ion::imgui_params const & params)
+{
+    ion::font_atlas result{ std::make_unique<ImFontAtlas>() };
+    auto & atlas = *result.atlas;
+    if (params.fonts.empty()) {
+        atlas.AddFontDefault();
+    }
+    for (auto const & [path, size, glyphs] : params.fonts) {
+        if (not std::filesystem::exists(path)) {
+            return std::unexpected("No font named " + path.string());
+        }
+        if (not atlas.AddFontFromFileTTF(path.string().c_str(), size, nullptr,
+                                         find_glyph_ranges(atlas, glyphs))) {
+            return std::unexpected("Couldn't load font " + path.string());
+        }
+    }
+    std::filesystem::path cache_path;
+    std::uint64_t key = 0u;
+    if (not params.font_cache.empty()) {
+        key = ion::font_atlas_key(atlas);
+        cache_path = ion::font_cache_path(params.font_cache, key);
+        result.cached = ion::load_font_atlas(cache_path, key, atlas);
+    }
+    if (not result.cached) {
+        if (not atlas.Build()) {
+            return std::unexpected("Couldn't build the font atlas");
+        }
+        // a cache that can't be written only costs the next startup
+        if (not cache_path.empty()) {
+            ion::save_font_atlas(cache_path, key, atlas);
+        }
+    }
+    // convert the pixels for the OpenGL backend up front as well
+    unsigned char * pixels;
+    int width;
+    int height;
+    atlas.GetTexDataAsRGBA32(&pixels, &width, &height);
+    return result;
+}
+
+/**
+ * \brief Stand in for a renderer backend when running headless
+ *
+ * ImGui still builds its draw data every frame, it's just never drawn.
+ */
+inline void init_null_renderer()
+{
+    ImGuiIO & io = ImGui::GetIO();
+    io.BackendRendererName = "ion_null";
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    // draw commands refer to the font texture, though nothing samples it
+    io.Fonts->SetTexID(reinterpret_cast<ImTextureID>(std::intptr_t{ 1 }));
+}
+
 inline std::expected<void, std::string>
 init_imgui(const imgui_params& params,
            SDL_Window* window,
-           SDL_GLContext gl_context)
+           SDL_GLContext gl_context,
+           ImFontAtlas* atlas)
 {
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
-    io.Fonts->AddFontDefault();
+    // the context shares the atlas, rather than owning it
+    ImGui::CreateContext(atlas);
 
+    // the SDL2 platform backend doesn't use the context, so headless
+    // systems initialize it the same way
     if (not ImGui_ImplSDL2_InitForOpenGL(window, gl_context)) {
         return std::unexpected("Couldn't initialize imgui SDL2");
     }
+    if (not gl_context) {
+        init_null_renderer();
+        return {};
+    }
     if (not ImGui_ImplOpenGL3_Init(params.glsl_version.c_str())) {
         return std::unexpected("Couldn't initialize imgui OpenGL3");
     }
@@ -589,6 +1245,297 @@ init_imgui(const imgui_params& params,
 }
 }
 
+namespace ion::detail {
+
+// imgui needs a few frames after input before its state settles
+inline std::uint32_t constexpr settle_frames = 3u;
+
+inline std::uint32_t redraw_event_type()
+{
+    static std::uint32_t const type = SDL_RegisterEvents(1);
+    return type;
+}
+}
+
+inline std::uint32_t ion::fixed_update::advance(double elapsed)
+{
+    accumulator += elapsed;
+    std::uint32_t steps = 0u;
+    for (; accumulator >= step() and steps < params.max_steps; ++steps) {
+        update_event.publish(step());
+        accumulator -= step();
+    }
+    // drop time that couldn't be caught up on, rather than spiral
+    if (accumulator >= step()) {
+        accumulator = 0.0;
+    }
+    return steps;
+}
+
+inline auto ion::system::on_update()
+{
+    return entt::sink{ get_subsystem<ion::fixed_update>().update_event };
+}
+
+inline auto ion::system::on_first_frame()
+{
+    return entt::sink{
+        get_subsystem<ion::startup_timings>().first_frame_event
+    };
+}
+
+inline double ion::system::interpolation() const
+{
+    auto const * update = try_get_subsystem<ion::fixed_update>();
+    return update ? update->alpha() : 0.0;
+}
+
+namespace ion::detail {
+
+/** The main loop, which needs a system's signals */
+struct main_loop {
+    static bool handle_event(ion::system & system, SDL_Event const & event);
+    // delta_time overrides the time step imgui sees, if positive
+    static void render_frame(ion::system & system, float delta_time = 0.f);
+    static void replay(ion::system & system, ion::input_replay & input);
+    static void run(ion::system & system);
+    static void shutdown(ion::system & system);
+};
+}
+
+inline void ion::request_redraw()
+{
+    SDL_Event event{};
+    event.type = detail::redraw_event_type();
+    SDL_PushEvent(&event);
+}
+
+inline bool
+ion::detail::main_loop::handle_event(ion::system & system,
+                                     SDL_Event const & event)
+{
+    ImGui_ImplSDL2_ProcessEvent(&event);
+    switch (event.type) {
+    case SDL_QUIT:
+        return false;
+    case SDL_KEYDOWN:
+        system.keydown_event.publish(event.key.keysym);
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+inline void ion::detail::main_loop::render_frame(ion::system & system,
+                                                 float delta_time)
+{
+    // headless systems have no context, and draw nothing
+    if (system._gl_context) {
+        ImGui_ImplOpenGL3_NewFrame();
+    }
+    ImGui_ImplSDL2_NewFrame();
+    if (delta_time > 0.f) {
+        ImGui::GetIO().DeltaTime = delta_time;
+    }
+    ImGui::NewFrame();
+    if (auto * schedule = system.try_get_subsystem<ion::scheduler>()) {
+        schedule->run(ion::phase::render);
+    }
+    system.render_event.publish(system._window);
+    ImGui::Render();
+    if (not system._gl_context) {
+        return;
+    }
+
+    ImGuiIO const & io = ImGui::GetIO();
+    glViewport(0, 0, static_cast<int>(io.DisplaySize.x),
+                     static_cast<int>(io.DisplaySize.y));
+    glClearColor(0.f, 0.f, 0.f, 1.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    SDL_GL_SwapWindow(system._window);
+}
+
+inline void ion::detail::main_loop::replay(ion::system & system,
+                                           ion::input_replay & input)
+{
+    auto & update = system.get_subsystem<ion::fixed_update>();
+    auto * pool = system.try_get_subsystem<ion::jobs>();
+    auto * schedule = system.try_get_subsystem<ion::scheduler>();
+
+    std::vector<ion::frame_timing> timings;
+    ion::input_frame frame;
+    bool is_running = true;
+    while (is_running and input.next(frame)) {
+        // real input is ignored while replaying, besides quitting
+        SDL_Event event;
+        while (SDL_PollEvent(&event) != 0) {
+            is_running = event.type != SDL_QUIT and is_running;
+        }
+        ion::performance_timer timer;
+        for (auto const & recorded : frame.events) {
+            is_running = handle_event(system, recorded) and is_running;
+        }
+        if (pool) {
+            pool->drain_main_thread();
+        }
+        if (schedule) {
+            schedule->run(ion::phase::pre_update, pool);
+        }
+        // run the recorded updates, whatever the time between frames is now
+        for (std::uint32_t step = 0u; step < frame.steps; ++step) {
+            update.update_event.publish(update.step());
+        }
+        if (schedule) {
+            schedule->run(ion::phase::post_update, pool);
+        }
+        auto const update_time = timer.lap();
+        if (frame.rendered) {
+            render_frame(system, frame.delta_time);
+        }
+        timings.push_back({ input.frame_index() - 1u,
+                            static_cast<std::uint32_t>(frame.events.size()),
+                            frame.steps, update_time, timer.lap() });
+    }
+    auto const * params = system.try_get_subsystem<ion::input_params>();
+    if (params and not params->timings.empty()) {
+        ion::write_timings(params->timings, timings);
+    }
+}
+
+inline void ion::detail::main_loop::run(ion::system & system)
+{
+    if (auto * input = system.try_get_subsystem<ion::input_replay>()) {
+        replay(system, *input);
+        return;
+    }
+    ion::loop_params params;
+    if (auto const * loop = system.try_get_subsystem<ion::loop_params>()) {
+        params = *loop;
+    }
+    auto & update = system.get_subsystem<ion::fixed_update>();
+    using milliseconds = std::chrono::duration<double, std::milli>;
+    using seconds = std::chrono::duration<double>;
+    // laps measure the time between updates, splits the time since rendering
+    ion::performance_timer update_timer;
+    ion::performance_timer render_timer;
+
+    auto * startup = system.try_get_subsystem<ion::startup_timings>();
+    // jobs finishing on the main thread should wake an idle loop
+    auto * pool = system.try_get_subsystem<ion::jobs>();
+    if (pool) {
+        pool->set_wake(&ion::request_redraw);
+    }
+    auto * schedule = system.try_get_subsystem<ion::scheduler>();
+    auto * recorder = system.try_get_subsystem<ion::input_recorder>();
+    auto * statistics = system.try_get_subsystem<ion::frame_statistics>();
+
+    std::uint32_t settle_frames = detail::settle_frames;
+    bool is_running = true;
+    while (is_running) {
+        SDL_Event event;
+        bool has_event;
+        // block until there's input, a redraw request, an update is due or
+        // the frame interval is up
+        if (params.idle and settle_frames == 0u) {
+            double timeout = params.max_frame_interval;
+            if (not update.update_event.empty()) {
+                timeout = std::min(timeout,
+                                   update.time_until_update() * 1000.0);
+            }
+            // round up, so waits under a millisecond don't spin
+            has_event = SDL_WaitEventTimeout(
+                &event, static_cast<int>(std::ceil(std::max(timeout, 0.0))))
+                != 0;
+        }
+        else {
+            has_event = SDL_PollEvent(&event) != 0;
+        }
+        // measures the work of this iteration, after waiting
+        ion::performance_timer work_timer;
+        for (; has_event; has_event = SDL_PollEvent(&event) != 0) {
+            is_running = handle_event(system, event) and is_running;
+            settle_frames = detail::settle_frames;
+            if (recorder) {
+                recorder->record(event);
+            }
+        }
+        if (pool) {
+            pool->drain_main_thread();
+        }
+        if (schedule) {
+            schedule->run(ion::phase::pre_update, pool);
+        }
+        auto const steps = update.advance(seconds{ update_timer.lap() }.count());
+        if (schedule) {
+            schedule->run(ion::phase::post_update, pool);
+        }
+        if (statistics) {
+            statistics->update.record(work_timer.lap());
+        }
+
+        // updates that change what's shown should request a redraw
+        double const since_render = milliseconds{ render_timer.split() }.count();
+        bool const render = not params.idle or settle_frames > 0u or
+                            since_render >= params.max_frame_interval;
+        if (render) {
+            render_frame(system);
+            auto const frame_time = render_timer.lap();
+            if (statistics) {
+                statistics->render.record(work_timer.lap());
+                statistics->frame.record(frame_time);
+            }
+            if (startup and not startup->reported) {
+                startup->reported = true;
+                startup->first_frame = startup->timer.elapsed();
+                startup->first_frame_event.publish(*startup);
+            }
+        }
+        if (recorder) {
+            recorder->end_frame(steps, render,
+                                render ? ImGui::GetIO().DeltaTime : 0.f);
+        }
+        if (settle_frames > 0u) {
+            --settle_frames;
+        }
+    }
+}
+
+inline void ion::detail::main_loop::shutdown(ion::system & system)
+{
+    if (system.moved) {
+        return;
+    }
+    if (system._gl_context) {
+        ImGui_ImplOpenGL3_Shutdown();
+    }
+    else {
+        // the null renderer has nothing to release
+        ImGui::GetIO().BackendRendererName = nullptr;
+    }
+    ImGui_ImplSDL2_Shutdown();
+    ImGui::DestroyContext();
+    detail::cleanup(system._window, system._gl_context);
+    system._window = nullptr;
+    system._gl_context = nullptr;
+    // the library's destructor does nothing for systems that were moved from
+    system.moved = true;
+}
+
+inline void ion::run(ion::system & system)
+{
+    detail::main_loop::run(system);
+    if (not system.gl_context()) {
+        ion::shutdown(system);
+    }
+}
+
+inline void ion::shutdown(ion::system & system)
+{
+    detail::main_loop::shutdown(system);
+}
+
 template<std::ranges::output_range<YAML::Exception> error_output>
 inline std::expected<ion::system, std::string>
 ion::system::from_config(const YAML::Node& config, error_output & yaml_errors)
@@ -598,6 +1545,23 @@ ion::system::from_config(const YAML::Node& config, error_output & yaml_errors)
 
     SDL_Window* window;
     SDL_GLContext gl_context;
+    ion::startup_timings startup;
+
+    // fonts only depend on their settings, so start building them first
+    ion::imgui_params imgui_params;
+    if (auto const imgui_config = config["imgui"]) {
+        std::vector<YAML::Exception> imgui_errors;
+        konbu::read(imgui_config, imgui_params, imgui_errors);
+        ranges::transform(imgui_errors,
+                          konbu::back_inserter_preference(yaml_errors),
+                          konbu::contextualize_setting("imgui"));
+    }
+    auto fonts = std::async(std::launch::async, [&settings = imgui_params]
+    {
+        ion::performance_timer const timer;
+        auto atlas = detail::build_font_atlas(settings);
+        return std::pair{ std::move(atlas), timer.elapsed() };
+    });
 
     ion::init_params init_params;
     if (auto const system_config = config["system"]) {
@@ -617,7 +1581,7 @@ ion::system::from_config(const YAML::Node& config, error_output & yaml_errors)
                           konbu::back_inserter_preference(yaml_errors),
                           konbu::contextualize_setting("window"));
     }
-    window = TRY(detail::load_window(window_params),
+    window = TRY(detail::load_window(window_params, init_params.headless),
                  detail::cleanup(nullptr, nullptr));
 
     ion::opengl_params gl_params;
@@ -628,21 +1592,75 @@ ion::system::from_config(const YAML::Node& config, error_output & yaml_errors)
                           konbu::back_inserter_preference(yaml_errors),
                           konbu::contextualize_setting("opengl"));
     }
-    gl_context = TRY(detail::load_opengl(gl_params, window),
-                     detail::cleanup(window, nullptr));
+    gl_context = nullptr;
+    if (not init_params.headless) {
+        gl_context = TRY(detail::load_opengl(gl_params, window),
+                         detail::cleanup(window, nullptr));
+    }
 
-    ion::imgui_params imgui_params;
-    if (auto const imgui_config = config["imgui"]) {
-        std::vector<YAML::Exception> imgui_errors;
-        konbu::read(imgui_config, imgui_params, imgui_errors);
-        ranges::transform(imgui_errors,
-                          konbu::back_inserter_preference(yaml_errors),
-                          konbu::contextualize_setting("imgui"));
+    auto [atlas, font_time] = fonts.get();
+    if (not atlas) {
+        detail::cleanup(window, gl_context);
+        return std::unexpected(atlas.error());
     }
-    TRY_VOID(detail::init_imgui(imgui_params, window, gl_context),
+    startup.fonts = font_time;
+    startup.fonts_cached = atlas->cached;
+    TRY_VOID(detail::init_imgui(imgui_params, window, gl_context,
+                                atlas->atlas.get()),
              detail::cleanup(window, gl_context));
 
-    return system(window, gl_context);
+    ion::loop_params loop_params;
+    if (auto const loop_config = config["loop"]) {
+        std::vector<YAML::Exception> loop_errors;
+        konbu::read(loop_config, loop_params, loop_errors);
+        ranges::transform(loop_errors,
+                          konbu::back_inserter_preference(yaml_errors),
+                          konbu::contextualize_setting("loop"));
+    }
+    ion::input_params input_params;
+    if (auto const input_config = config["input"]) {
+        std::vector<YAML::Exception> input_errors;
+        konbu::read(input_config, input_params, input_errors);
+        ranges::transform(input_errors,
+                          konbu::back_inserter_preference(yaml_errors),
+                          konbu::contextualize_setting("input"));
+    }
+    ion::update_params update_params;
+    if (auto const update_config = config["update"]) {
+        std::vector<YAML::Exception> update_errors;
+        konbu::read(update_config, update_params, update_errors);
+        ranges::transform(update_errors,
+                          konbu::back_inserter_preference(yaml_errors),
+                          konbu::contextualize_setting("update"));
+    }
+    system result{ window, gl_context };
+    result.add_subsystem<ion::loop_params>() = loop_params;
+    auto & update = result.add_subsystem<ion::fixed_update>();
+    update.params = update_params;
+
+    // replays run at the update rate they were recorded at
+    if (not input_params.replay.empty()) {
+        auto & replay = result.add_subsystem<ion::input_replay>();
+        if (not replay.open(input_params.replay)) {
+            ion::shutdown(result);
+            return std::unexpected("Couldn't replay " +
+                                   input_params.replay.string());
+        }
+        update.params.rate = replay.update_rate();
+    }
+    if (not input_params.record.empty()) {
+        auto & recorder = result.add_subsystem<ion::input_recorder>();
+        if (not recorder.open(input_params.record, update.params.rate)) {
+            ion::shutdown(result);
+            return std::unexpected("Couldn't record to " +
+                                   input_params.record.string());
+        }
+    }
+    result.add_subsystem<ion::input_params>() = input_params;
+    result.add_subsystem<ion::font_atlas>() = std::move(*atlas);
+    startup.initialized = startup.timer.elapsed();
+    result.add_subsystem<ion::startup_timings>() = std::move(startup);
+    return result;
 }
 
 template<std::ranges::output_range<YAML::Exception> error_output>
@@ -0,0 +1,324 @@
+#pragma once
+#include "ion/tag.hpp"
+
+// serialization
+#include <yaml-cpp/yaml.h>
+#include "konbu/konbu.h"
+#include <iostream>
+
+// data types
+#include <array>
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ion {
+
+/**
+ * \brief An interned tag, which supports dot-separated tagging operations
+ *
+ * Tags are interned in a global, thread-safe table, so a tag_id is a 32-bit
+ * id with O(1) equality and a precomputed hash. Interning a tag also interns
+ * its parents, e.g. `ui.panel` and `ui` for `ui.panel.button`, so
+ * hierarchy queries follow parent links instead of comparing strings.
+ *
+ * Ids are dense and start at 0 for the empty tag, so they can index arrays
+ * and bitsets directly.
+ */
+class tag_id {
+public:
+    inline tag_id() = default;
+
+    inline explicit tag_id(std::string_view str) : _id{ intern(str) } {}
+    inline explicit tag_id(std::string const & str)
+        : tag_id{ std::string_view{ str } } {}
+    inline explicit tag_id(char const * str) : tag_id{ std::string_view{ str } } {}
+    inline explicit tag_id(ion::tag const & tag) : tag_id{ tag.c_str() } {}
+
+    /** The tag that was interned. */
+    [[nodiscard]] inline ion::tag tag() const { return ion::tag{ c_str() }; }
+    [[nodiscard]] inline std::string string() const { return std::string{ view() }; }
+    /** The interned string, which lives as long as the program. */
+    [[nodiscard]] std::string_view view() const;
+    [[nodiscard]] char const * c_str() const;
+
+    /** The dense id of the tag. */
+    [[nodiscard]] inline std::uint32_t id() const { return _id; }
+    [[nodiscard]] std::size_t hash() const;
+    [[nodiscard]] inline bool empty() const { return _id == 0u; }
+
+    /** The tag without its last part, or the empty tag for a root tag. */
+    [[nodiscard]] ion::tag_id parent() const;
+
+    /** The number of dot-separated parts in the tag. */
+    [[nodiscard]] std::uint32_t depth() const;
+
+    /** Determine if the tag is nested anywhere under another tag. */
+    [[nodiscard]] bool is_child_of(ion::tag_id ancestor) const;
+
+    /** Determine if the tag is another tag, or nested under it. */
+    [[nodiscard]] bool matches_prefix(ion::tag_id prefix) const;
+
+    /** The number of tags interned so far, an upper bound for ids. */
+    [[nodiscard]] static std::uint32_t count();
+
+    /** Find the tag with an id. */
+    [[nodiscard]] static ion::tag_id from_id(std::uint32_t id);
+
+    inline bool operator==(tag_id const & rhs) const { return _id == rhs._id; }
+    /** Tags are ordered by their strings. */
+    std::strong_ordering operator<=>(tag_id const & rhs) const;
+private:
+    static std::uint32_t intern(std::string_view str);
+    std::uint32_t _id = 0u;
+};
+}
+std::ostream & operator<<(std::ostream & os, ion::tag_id const & tag);
+std::istream & operator>>(std::istream & is, ion::tag_id & tag);
+
+namespace std {
+template<>
+struct hash<ion::tag_id> {
+    size_t operator()(ion::tag_id const& tag) const;
+};
+}
+namespace konbu {
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config, ion::tag_id & value, error_output & errors);
+}
+namespace YAML {
+template<>
+struct convert<ion::tag_id> {
+    static Node encode(ion::tag_id const & tag);
+};
+}
+
+namespace ion::detail {
+
+struct tag_entry {
+    std::string name;
+    std::size_t hash = 0u;
+    std::uint32_t parent = 0u;
+    std::uint32_t depth = 0u;
+};
+
+struct string_hash {
+    using is_transparent = void;
+    inline std::size_t operator()(std::string_view str) const
+    {
+        return std::hash<std::string_view>{}(str);
+    }
+};
+
+/**
+ * \brief The global table of interned tags
+ *
+ * Entries live in fixed-size chunks that never move, so reading an entry by
+ * id takes no lock. Interning takes a shared lock to find a tag, and an
+ * exclusive lock only to add one.
+ */
+class tag_table {
+public:
+    static constexpr std::size_t chunk_size = 1024u;
+    static constexpr std::size_t max_chunks = 4096u;
+
+    static tag_table & instance();
+
+    std::uint32_t intern(std::string_view name);
+
+    [[nodiscard]] inline tag_entry const & entry(std::uint32_t id) const
+    {
+        return chunks[id / chunk_size].load(std::memory_order_acquire)
+                     [id % chunk_size];
+    }
+    [[nodiscard]] inline std::uint32_t count() const
+    {
+        return size.load(std::memory_order_acquire);
+    }
+private:
+    tag_table();
+    // expects the exclusive lock to be held
+    std::uint32_t add(std::string_view name, std::uint32_t parent);
+
+    std::array<std::atomic<tag_entry *>, max_chunks> chunks{};
+    std::vector<std::unique_ptr<tag_entry[]>> storage;
+    std::atomic<std::uint32_t> size = 0u;
+
+    std::shared_mutex mutex;
+    std::unordered_map<std::string_view, std::uint32_t,
+                       string_hash, std::equal_to<>> ids;
+};
+
+inline tag_table & tag_table::instance()
+{
+    static tag_table table;
+    return table;
+}
+
+inline tag_table::tag_table()
+{
+    std::scoped_lock const lock{ mutex };
+    add("", 0u);
+}
+
+inline std::uint32_t tag_table::add(std::string_view name, std::uint32_t parent)
+{
+    std::uint32_t const id = size.load(std::memory_order_relaxed);
+    std::size_t const chunk = id / chunk_size;
+    if (chunk >= max_chunks) {
+        throw std::length_error{ "too many interned tags" };
+    }
+    if (id % chunk_size == 0u) {
+        storage.push_back(std::make_unique<tag_entry[]>(chunk_size));
+        chunks[chunk].store(storage.back().get(), std::memory_order_release);
+    }
+    auto & added = chunks[chunk].load(std::memory_order_relaxed)[id % chunk_size];
+    added.name = name;
+    added.hash = std::hash<std::string_view>{}(added.name);
+    added.parent = parent;
+    added.depth = name.empty() ? 0u : entry(parent).depth + 1u;
+    // the key views the entry's own string, which never moves
+    ids.emplace(std::string_view{ added.name }, id);
+    size.store(id + 1u, std::memory_order_release);
+    return id;
+}
+
+inline std::uint32_t tag_table::intern(std::string_view name)
+{
+    {
+        std::shared_lock const lock{ mutex };
+        if (auto const search = ids.find(name); search != ids.end()) {
+            return search->second;
+        }
+    }
+    std::scoped_lock const lock{ mutex };
+    // intern each parent on the way down, e.g. ui, ui.panel, ui.panel.button
+    // empty parts are kept, so ".a", "a." and "a..b" each have their prefixes
+    std::uint32_t parent = 0u;
+    std::size_t start = 0u;
+    while (true) {
+        auto const end = name.find('.', start);
+        auto const prefix = name.substr(0u, end);
+        auto const search = ids.find(prefix);
+        parent = search != ids.end() ? search->second : add(prefix, parent);
+        if (end == std::string_view::npos) {
+            return parent;
+        }
+        start = end + 1u;
+    }
+}
+}
+
+inline std::string_view ion::tag_id::view() const
+{
+    return detail::tag_table::instance().entry(_id).name;
+}
+
+inline char const * ion::tag_id::c_str() const
+{
+    return detail::tag_table::instance().entry(_id).name.c_str();
+}
+
+inline std::size_t ion::tag_id::hash() const
+{
+    return detail::tag_table::instance().entry(_id).hash;
+}
+
+inline ion::tag_id ion::tag_id::parent() const
+{
+    return from_id(detail::tag_table::instance().entry(_id).parent);
+}
+
+inline std::uint32_t ion::tag_id::depth() const
+{
+    return detail::tag_table::instance().entry(_id).depth;
+}
+
+inline bool ion::tag_id::is_child_of(ion::tag_id ancestor) const
+{
+    auto const & table = detail::tag_table::instance();
+    auto const ancestor_depth = table.entry(ancestor._id).depth;
+    std::uint32_t id = _id;
+    // walk up to the ancestor's depth, then compare once
+    for (auto depth = table.entry(id).depth; depth > ancestor_depth; --depth) {
+        id = table.entry(id).parent;
+        if (depth - 1u == ancestor_depth) {
+            return id == ancestor._id;
+        }
+    }
+    return false;
+}
+
+inline bool ion::tag_id::matches_prefix(ion::tag_id prefix) const
+{
+    return *this == prefix or is_child_of(prefix);
+}
+
+inline std::uint32_t ion::tag_id::count()
+{
+    return detail::tag_table::instance().count();
+}
+
+inline ion::tag_id ion::tag_id::from_id(std::uint32_t id)
+{
+    ion::tag_id result;
+    result._id = id;
+    return result;
+}
+
+inline std::strong_ordering ion::tag_id::operator<=>(tag_id const & rhs) const
+{
+    if (_id == rhs._id) {
+        return std::strong_ordering::equal;
+    }
+    return view() <=> rhs.view();
+}
+
+inline std::uint32_t ion::tag_id::intern(std::string_view str)
+{
+    return detail::tag_table::instance().intern(str);
+}
+
+inline std::ostream & operator<<(std::ostream & os, ion::tag_id const & tag)
+{
+    return os << tag.view();
+}
+
+inline std::istream & operator>>(std::istream & is, ion::tag_id & tag)
+{
+    std::string str;
+    if (is >> str) {
+        tag = ion::tag_id{ str };
+    }
+    return is;
+}
+
+inline std::size_t
+std::hash<ion::tag_id>::operator()(ion::tag_id const & tag) const
+{
+    return tag.hash();
+}
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline void konbu::read(YAML::Node const & config,
+                        ion::tag_id & value,
+                        error_output & errors)
+{
+    std::string input;
+    konbu::read(config, input, errors);
+    value = ion::tag_id{ input };
+}
+inline YAML::Node
+YAML::convert<ion::tag_id>::encode(ion::tag_id const & tag)
+{
+    return Node{ tag.string() };
+}
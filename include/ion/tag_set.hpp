@@ -0,0 +1,466 @@
+#pragma once
+#include "ion/tag_id.hpp"
+
+#include <entt/entity/registry.hpp>
+
+// serialization
+#include <yaml-cpp/yaml.h>
+#include "konbu/konbu.h"
+
+// data types
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+namespace ion::detail {
+
+// a growable bitset, as words indexed by `bit / word_bits`
+using bit_word = std::uint64_t;
+inline constexpr std::size_t word_bits = 64u;
+
+inline void set_bit(std::vector<bit_word> & words, std::size_t bit)
+{
+    if (bit / word_bits >= words.size()) {
+        words.resize(bit / word_bits + 1u, 0u);
+    }
+    words[bit / word_bits] |= bit_word{ 1u } << (bit % word_bits);
+}
+
+inline void reset_bit(std::vector<bit_word> & words, std::size_t bit)
+{
+    if (bit / word_bits < words.size()) {
+        words[bit / word_bits] &= ~(bit_word{ 1u } << (bit % word_bits));
+    }
+}
+
+inline bool test_bit(std::span<bit_word const> words, std::size_t bit)
+{
+    return bit / word_bits < words.size()
+       and (words[bit / word_bits] >> (bit % word_bits) & 1u) != 0u;
+}
+
+/** Call a function with the index of each set bit, in order. */
+template<std::invocable<std::size_t> function>
+void each_bit(std::span<bit_word const> words, function && fn)
+{
+    for (std::size_t i = 0u; i < words.size(); ++i) {
+        for (auto word = words[i]; word != 0u; word &= word - 1u) {
+            fn(i * word_bits + static_cast<std::size_t>(std::countr_zero(word)));
+        }
+    }
+}
+}
+
+namespace ion {
+
+/**
+ * \brief A set of tags, stored as bits indexed by tag id
+ *
+ * Besides its own tags, the set keeps a bit for every parent they imply, so
+ * hierarchical queries are plain bitwise operations over words: a set with
+ * `ui.panel.button` matches `ui.panel` and `ui` without walking parents.
+ *
+ * Queries come in two kinds:
+ *  - `contains` checks the set's own tags exactly
+ *  - `matches` also accepts a tag if the set has one of its descendants
+ */
+class tag_set {
+public:
+    tag_set() = default;
+    tag_set(std::initializer_list<ion::tag_id> tags);
+
+    void insert(ion::tag_id tag);
+    void erase(ion::tag_id tag);
+    void clear();
+
+    [[nodiscard]] bool empty() const;
+    /** The number of the set's own tags. */
+    [[nodiscard]] std::size_t size() const;
+
+    /** Determine if the set has exactly the tag. */
+    [[nodiscard]] bool contains(ion::tag_id tag) const;
+    /** Determine if the set has the tag, or one of its descendants. */
+    [[nodiscard]] bool matches(ion::tag_id tag) const;
+    /** Determine if the set has one of the tag's descendants. */
+    [[nodiscard]] bool has_descendant_of(ion::tag_id tag) const;
+
+    [[nodiscard]] bool contains_any(ion::tag_set const & query) const;
+    [[nodiscard]] bool contains_all(ion::tag_set const & query) const;
+    [[nodiscard]] bool matches_any(ion::tag_set const & query) const;
+    [[nodiscard]] bool matches_all(ion::tag_set const & query) const;
+
+    /** Call a function with each of the set's own tags, ordered by id. */
+    template<std::invocable<ion::tag_id> function>
+    void each(function && fn) const;
+
+    /** The words of the set's own tags, indexed by tag id. */
+    [[nodiscard]] inline std::span<detail::bit_word const> words() const
+    {
+        return own;
+    }
+
+    bool operator==(ion::tag_set const & rhs) const;
+private:
+    void imply(ion::tag_id tag);
+
+    std::vector<detail::bit_word> own;
+    // the strict ancestors of the set's own tags, as many words as `own`
+    std::vector<detail::bit_word> implied;
+};
+
+/**
+ * \brief Indexes the entities of a registry by the tags they match
+ *
+ * The index keeps a bitset of entities for each tag, with an entity in the
+ * rows of its own tags and their parents. Queries combine whole rows at a
+ * time, so selecting entities costs the number of entities over 64 per tag
+ * in the query, instead of a check per entity.
+ *
+ * Create the index with `ion::tag_index::watch(registry)`, and it follows
+ * every `ion::tag_set` constructed, updated or destroyed afterwards.
+ */
+class tag_index {
+public:
+    /** Get the registry's index, creating it the first time. */
+    static ion::tag_index & watch(entt::registry & entities);
+
+    /** The number of entities that match the tag. */
+    [[nodiscard]] std::size_t count(ion::tag_id tag) const;
+
+    /** Call a function with each entity that matches the tag. */
+    template<std::invocable<entt::entity> function>
+    void each(ion::tag_id tag, function && fn) const;
+
+    /** Find the entities that match any tag of the query. */
+    void find_any(ion::tag_set const & query,
+                  std::vector<entt::entity> & found) const;
+
+    /** Find the entities that match every tag of a non-empty query. */
+    void find_all(ion::tag_set const & query,
+                  std::vector<entt::entity> & found) const;
+private:
+    void insert(entt::entity entity, ion::tag_set const & tags);
+    void remove(entt::entity entity);
+    void collect(std::span<detail::bit_word const> slots,
+                 std::vector<entt::entity> & found) const;
+
+    static void on_change(entt::registry & entities, entt::entity entity);
+    static void on_destroy(entt::registry & entities, entt::entity entity);
+
+    // a row of entity slots for each tag id
+    std::vector<std::vector<detail::bit_word>> rows;
+    // the entity in each slot
+    std::vector<entt::entity> slots;
+};
+}
+
+namespace konbu {
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config, ion::tag_set & value, error_output & errors);
+}
+namespace YAML {
+template<>
+struct convert<ion::tag_set> {
+    static Node encode(ion::tag_set const & tags);
+};
+}
+
+inline ion::tag_set::tag_set(std::initializer_list<ion::tag_id> tags)
+{
+    for (auto const tag : tags) {
+        insert(tag);
+    }
+}
+
+inline void ion::tag_set::insert(ion::tag_id tag)
+{
+    detail::set_bit(own, tag.id());
+    imply(tag);
+    // parents are interned first, so they never need more words
+    implied.resize(own.size(), 0u);
+}
+
+inline void ion::tag_set::erase(ion::tag_id tag)
+{
+    if (not contains(tag)) {
+        return;
+    }
+    detail::reset_bit(own, tag.id());
+    // another tag may still imply the same parents
+    std::ranges::fill(implied, 0u);
+    detail::each_bit(own, [this](std::size_t id) {
+        imply(ion::tag_id::from_id(static_cast<std::uint32_t>(id)));
+    });
+}
+
+inline void ion::tag_set::clear()
+{
+    own.clear();
+    implied.clear();
+}
+
+inline void ion::tag_set::imply(ion::tag_id tag)
+{
+    for (auto parent = tag.parent(); not parent.empty(); parent = parent.parent()) {
+        detail::set_bit(implied, parent.id());
+    }
+}
+
+inline bool ion::tag_set::empty() const
+{
+    return std::ranges::all_of(own, [](auto word) { return word == 0u; });
+}
+
+inline std::size_t ion::tag_set::size() const
+{
+    std::size_t count = 0u;
+    for (auto const word : own) {
+        count += static_cast<std::size_t>(std::popcount(word));
+    }
+    return count;
+}
+
+inline bool ion::tag_set::contains(ion::tag_id tag) const
+{
+    return detail::test_bit(own, tag.id());
+}
+
+inline bool ion::tag_set::matches(ion::tag_id tag) const
+{
+    return contains(tag) or has_descendant_of(tag);
+}
+
+inline bool ion::tag_set::has_descendant_of(ion::tag_id tag) const
+{
+    return detail::test_bit(implied, tag.id());
+}
+
+inline bool ion::tag_set::contains_any(ion::tag_set const & query) const
+{
+    std::size_t const size = std::min(own.size(), query.own.size());
+    detail::bit_word found = 0u;
+    for (std::size_t i = 0u; i < size; ++i) {
+        found |= own[i] & query.own[i];
+    }
+    return found != 0u;
+}
+
+inline bool ion::tag_set::contains_all(ion::tag_set const & query) const
+{
+    detail::bit_word missing = 0u;
+    for (std::size_t i = 0u; i < query.own.size(); ++i) {
+        auto const have = i < own.size() ? own[i] : 0u;
+        missing |= query.own[i] & ~have;
+    }
+    return missing == 0u;
+}
+
+inline bool ion::tag_set::matches_any(ion::tag_set const & query) const
+{
+    std::size_t const size = std::min(own.size(), query.own.size());
+    detail::bit_word found = 0u;
+    for (std::size_t i = 0u; i < size; ++i) {
+        found |= (own[i] | implied[i]) & query.own[i];
+    }
+    return found != 0u;
+}
+
+inline bool ion::tag_set::matches_all(ion::tag_set const & query) const
+{
+    detail::bit_word missing = 0u;
+    for (std::size_t i = 0u; i < query.own.size(); ++i) {
+        auto const have = i < own.size() ? own[i] | implied[i] : 0u;
+        missing |= query.own[i] & ~have;
+    }
+    return missing == 0u;
+}
+
+template<std::invocable<ion::tag_id> function>
+inline void ion::tag_set::each(function && fn) const
+{
+    detail::each_bit(own, [&fn](std::size_t id) {
+        fn(ion::tag_id::from_id(static_cast<std::uint32_t>(id)));
+    });
+}
+
+inline bool ion::tag_set::operator==(ion::tag_set const & rhs) const
+{
+    return contains_all(rhs) and rhs.contains_all(*this);
+}
+
+inline ion::tag_index & ion::tag_index::watch(entt::registry & entities)
+{
+    if (auto * index = entities.ctx().find<ion::tag_index>()) {
+        return *index;
+    }
+    entities.on_construct<ion::tag_set>().connect<&tag_index::on_change>();
+    entities.on_update<ion::tag_set>().connect<&tag_index::on_change>();
+    entities.on_destroy<ion::tag_set>().connect<&tag_index::on_destroy>();
+    auto & index = entities.ctx().emplace<ion::tag_index>();
+    for (auto const entity : entities.view<ion::tag_set>()) {
+        index.insert(entity, entities.get<ion::tag_set>(entity));
+    }
+    return index;
+}
+
+inline void ion::tag_index::on_change(entt::registry & entities,
+                                      entt::entity entity)
+{
+    auto & index = entities.ctx().get<ion::tag_index>();
+    index.remove(entity);
+    index.insert(entity, entities.get<ion::tag_set>(entity));
+}
+
+inline void ion::tag_index::on_destroy(entt::registry & entities,
+                                       entt::entity entity)
+{
+    entities.ctx().get<ion::tag_index>().remove(entity);
+}
+
+inline void ion::tag_index::insert(entt::entity entity,
+                                   ion::tag_set const & tags)
+{
+    auto const slot = static_cast<std::size_t>(entt::to_entity(entity));
+    if (slot >= slots.size()) {
+        slots.resize(slot + 1u, entt::null);
+    }
+    slots[slot] = entity;
+    auto const add = [this, slot](std::size_t id) {
+        if (id >= rows.size()) {
+            rows.resize(id + 1u);
+        }
+        detail::set_bit(rows[id], slot);
+    };
+    tags.each([&add](ion::tag_id tag) {
+        // rows include every parent, so a row answers hierarchical queries
+        for (; not tag.empty(); tag = tag.parent()) {
+            add(tag.id());
+        }
+    });
+}
+
+inline void ion::tag_index::remove(entt::entity entity)
+{
+    auto const slot = static_cast<std::size_t>(entt::to_entity(entity));
+    if (slot >= slots.size() or slots[slot] != entity) {
+        return;
+    }
+    slots[slot] = entt::null;
+    for (auto & row : rows) {
+        detail::reset_bit(row, slot);
+    }
+}
+
+inline std::size_t ion::tag_index::count(ion::tag_id tag) const
+{
+    if (tag.id() >= rows.size()) {
+        return 0u;
+    }
+    std::size_t count = 0u;
+    for (auto const word : rows[tag.id()]) {
+        count += static_cast<std::size_t>(std::popcount(word));
+    }
+    return count;
+}
+
+template<std::invocable<entt::entity> function>
+inline void ion::tag_index::each(ion::tag_id tag, function && fn) const
+{
+    if (tag.id() >= rows.size()) {
+        return;
+    }
+    detail::each_bit(rows[tag.id()], [this, &fn](std::size_t slot) {
+        fn(slots[slot]);
+    });
+}
+
+inline void ion::tag_index::collect(std::span<detail::bit_word const> found_slots,
+                                    std::vector<entt::entity> & found) const
+{
+    detail::each_bit(found_slots, [this, &found](std::size_t slot) {
+        found.push_back(slots[slot]);
+    });
+}
+
+inline void ion::tag_index::find_any(ion::tag_set const & query,
+                                     std::vector<entt::entity> & found) const
+{
+    std::vector<detail::bit_word> result;
+    query.each([this, &result](ion::tag_id tag) {
+        if (tag.id() >= rows.size()) {
+            return;
+        }
+        auto const & row = rows[tag.id()];
+        if (result.size() < row.size()) {
+            result.resize(row.size(), 0u);
+        }
+        for (std::size_t i = 0u; i < row.size(); ++i) {
+            result[i] |= row[i];
+        }
+    });
+    collect(result, found);
+}
+
+inline void ion::tag_index::find_all(ion::tag_set const & query,
+                                     std::vector<entt::entity> & found) const
+{
+    std::vector<detail::bit_word> result;
+    bool first = true;
+    query.each([this, &result, &first](ion::tag_id tag) {
+        if (tag.id() >= rows.size()) {
+            result.clear();
+            first = false;
+            return;
+        }
+        auto const & row = rows[tag.id()];
+        if (first) {
+            result = row;
+            first = false;
+            return;
+        }
+        result.resize(std::min(result.size(), row.size()));
+        for (std::size_t i = 0u; i < result.size(); ++i) {
+            result[i] &= row[i];
+        }
+    });
+    collect(result, found);
+}
+
+template<std::ranges::output_range<YAML::Exception> error_output>
+inline void konbu::read(YAML::Node const & config,
+                        ion::tag_set & value,
+                        error_output & errors)
+{
+    namespace ranges = std::ranges;
+    namespace views = std::views;
+
+    if (not config.IsSequence()) {
+        YAML::Exception const error{ config.Mark(), "expecting a sequence" };
+        ranges::copy(views::single(error), back_inserter_preference(errors));
+        return;
+    }
+    value.clear();
+    auto tag_errors = konbu::error_buffer_for(errors);
+    for (YAML::Node const & node : config) {
+        tag_errors.clear();
+        ion::tag_id tag;
+        konbu::read(node, tag, tag_errors);
+        if (tag_errors.empty()) {
+            value.insert(tag);
+        }
+        ranges::copy(tag_errors, back_inserter_preference(errors));
+    }
+}
+
+inline YAML::Node
+YAML::convert<ion::tag_set>::encode(ion::tag_set const & tags)
+{
+    Node node{ NodeType::Sequence };
+    tags.each([&node](ion::tag_id tag) { node.push_back(tag.string()); });
+    return node;
+}
@@ -1,6 +1,9 @@
 #pragma once
 #include <SDL2/SDL.h>
+#include <chrono>
+#include <concepts>
 #include <cstdint>
+#include <utility>
 
 namespace ion {
 
@@ -19,4 +22,117 @@ private:
     // the global time in milliseconds when the timer was started
     std::uint32_t start;
 };
+
+/**
+ * \brief A chrono clock reading SDL's high resolution performance counter
+ *
+ * The performance counter can be read without initializing SDL.
+ */
+struct performance_clock {
+    using rep = std::int64_t;
+    using period = std::nano;
+    using duration = std::chrono::duration<rep, period>;
+    using time_point = std::chrono::time_point<performance_clock>;
+    static constexpr bool is_steady = true;
+
+    /** \brief The current time of the performance counter. */
+    static time_point now();
+};
+
+/** \brief A clock that a timer can measure with */
+template<typename clock>
+concept timer_clock = std::chrono::is_clock_v<clock>;
+
+/**
+ * \brief A timer that measures with any chrono clock
+ * \tparam clock    the clock to measure with
+ *
+ * Besides the total elapsed time, the timer can split the time into laps.
+ */
+template<timer_clock clock>
+class basic_timer {
+public:
+    using duration = typename clock::duration;
+    using time_point = typename clock::time_point;
+
+    /** \brief Start a new timer. */
+    inline basic_timer() : start{ clock::now() }, lap_start{ start } {}
+
+    /** \brief The time since the timer started. */
+    [[nodiscard]] inline duration elapsed() const
+    {
+        return clock::now() - start;
+    }
+
+    /** \brief The time since the current lap started, without ending it. */
+    [[nodiscard]] inline duration split() const
+    {
+        return clock::now() - lap_start;
+    }
+
+    /** \brief End the current lap and start a new one. */
+    inline duration lap()
+    {
+        auto const now = clock::now();
+        auto const lap_time = now - lap_start;
+        lap_start = now;
+        return lap_time;
+    }
+
+    /** \brief Restart the timer and its lap. */
+    inline void reset()
+    {
+        start = clock::now();
+        lap_start = start;
+    }
+private:
+    time_point start;
+    time_point lap_start;
+};
+
+using steady_timer = basic_timer<std::chrono::steady_clock>;
+using performance_timer = basic_timer<ion::performance_clock>;
+
+/**
+ * \brief Report the time spent in a scope
+ *
+ * \tparam callback called with the elapsed time when the stopwatch is destroyed
+ * \tparam clock    the clock to measure with
+ */
+template<typename callback, timer_clock clock = std::chrono::steady_clock>
+requires std::invocable<callback &, typename clock::duration>
+class stopwatch {
+public:
+    inline explicit stopwatch(callback on_stop)
+        : on_stop{ std::move(on_stop) }
+    {
+    }
+    stopwatch(stopwatch const &) = delete;
+    stopwatch & operator=(stopwatch const &) = delete;
+
+    inline ~stopwatch() { on_stop(timer.elapsed()); }
+
+    /** \brief The time since the stopwatch started. */
+    [[nodiscard]] inline typename clock::duration elapsed() const
+    {
+        return timer.elapsed();
+    }
+private:
+    callback on_stop;
+    ion::basic_timer<clock> timer;
+};
+}
+
+inline ion::performance_clock::time_point ion::performance_clock::now()
+{
+    std::int64_t constexpr nanoseconds = 1'000'000'000;
+    auto const counter = static_cast<std::int64_t>(SDL_GetPerformanceCounter());
+    auto const frequency =
+        static_cast<std::int64_t>(SDL_GetPerformanceFrequency());
+
+    // split the counter so that converting it to nanoseconds can't overflow
+    auto const seconds = counter / frequency;
+    auto const remainder = counter % frequency;
+    return time_point{ duration{ seconds * nanoseconds +
+                                 remainder * nanoseconds / frequency } };
 }
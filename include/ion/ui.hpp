@@ -1,6 +1,19 @@
 #pragma once
 #include <ranges>
 #include <functional>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <climits>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ion/quantile.hpp"
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include "imgui/imgui.h"
 #include "imgui/imgui_internal.h"
@@ -13,6 +26,83 @@ const ImVec2 ButtonSize{ 100.f, 20.f };
 const ImVec2 WindowSize{ 400.f, 300.f };
 }
 
+/**
+ * \brief Copy text into scratch memory that lasts until the next frame
+ * \return the copy, null-terminated for imgui
+ *
+ * Scratch memory is reused every frame, and only grows when a frame needs
+ * more than any frame before it, so steady-state frames don't allocate.
+ */
+char const * FrameString(std::string_view text);
+
+/** Reserve scratch memory that lasts until the next frame. */
+char * FrameAlloc(std::size_t size);
+
+/**
+ * \brief A widget's label or id, which doesn't allocate
+ *
+ * Null-terminated strings are passed to imgui as they are. Other string
+ * views, and ids, are copied into scratch memory for the frame when used.
+ *
+ * \note A label made from a std::string views it, so the string has to
+ *       outlive the label.
+ */
+class Label {
+public:
+    constexpr Label(char const * text) : text{ text }, terminated{ true } {}
+    inline Label(std::string const & text) : text{ text }, terminated{ true } {}
+    constexpr Label(std::string_view text) : text{ text } {}
+    /** A hidden label, for widgets told apart by an id. */
+    constexpr explicit Label(ImGuiID id) : id{ id }, is_id{ true } {}
+
+    /** The label as a null-terminated string. */
+    [[nodiscard]] char const * c_str() const;
+private:
+    std::string_view text;
+    ImGuiID id = 0u;
+    bool terminated = false;
+    bool is_id = false;
+};
+
+/** A format string, whose `{}` placeholders are counted at compile time */
+template<std::size_t N>
+struct FormatString {
+    consteval FormatString(char const (&text)[N])
+    {
+        std::copy_n(text, N, chars);
+    }
+    [[nodiscard]] consteval std::size_t Placeholders() const
+    {
+        std::size_t count = 0u;
+        for (std::size_t i = 0u; i + 1u < N; ++i) {
+            if (chars[i] == '{' and chars[i + 1u] == '}') {
+                ++count;
+            }
+        }
+        return count;
+    }
+    char chars[N]{};
+};
+
+/** A value that FormatLabel can write */
+template<typename T>
+concept FormatArgument = (std::integral<T> and not std::same_as<T, bool>)
+                      or std::floating_point<T>
+                      or std::convertible_to<T const &, std::string_view>;
+
+/**
+ * \brief Format a label into scratch memory for the frame
+ *
+ * e.g. `ImGui::FormatLabel<"align-{}">(i)` or
+ * `ImGui::FormatLabel<"{}##{}">(name, index)`. The number of arguments has
+ * to match the placeholders, which is checked when compiling.
+ *
+ * \return the label, null-terminated, valid until the next frame
+ */
+template<FormatString format, FormatArgument... Args>
+requires (sizeof...(Args) == format.Placeholders())
+char const * FormatLabel(Args const &... args);
+
 template<std::ranges::range Range,
          std::invocable<std::ranges::range_value_t<Range>> Projection = std::identity>
 requires std::convertible_to<
@@ -74,6 +164,158 @@ void ButtonList(Range const & elems,
     }
 }
 
+/**
+ * \brief Caches the text projected from each row of a large list
+ *
+ * Pass the cache as the projection of a clipped list, and each visible row
+ * is projected once, then reused on later frames. Invalidate rows when their
+ * elements change.
+ */
+template<typename Projection>
+class TextCache {
+public:
+    TextCache() = default;
+    explicit TextCache(Projection project) : project{ std::move(project) } {}
+
+    template<std::ranges::random_access_range Range>
+    std::string_view operator()(Range const & elements, std::size_t index) const;
+
+    /** Forget every row, e.g. after the list was reordered. */
+    void Invalidate() const { cached.clear(); }
+    /** Forget one row. */
+    void Invalidate(std::size_t index) const;
+private:
+    Projection project;
+    mutable std::vector<std::string> texts;
+    mutable std::vector<bool> cached;
+};
+
+namespace detail {
+/** The text of a row, from a row cache or by projecting its element. */
+template<std::ranges::random_access_range Range, typename Projection>
+decltype(auto) RowText(Range const & elements,
+                       std::size_t index,
+                       Projection const & project)
+{
+    if constexpr (std::invocable<Projection const &, Range const &, std::size_t>) {
+        return project(elements, index);
+    }
+    else {
+        using difference = std::ranges::range_difference_t<Range>;
+        using reference = std::ranges::range_reference_t<Range const>;
+        using text = std::invoke_result_t<Projection const &, reference>;
+        auto const first = std::ranges::begin(elements);
+        // a projection of a prvalue element, like std::identity, returns a
+        // reference into a temporary, so the text has to be copied out of it
+        if constexpr (not std::is_reference_v<reference> and
+                      std::is_reference_v<text>) {
+            return std::remove_cvref_t<text>(
+                std::invoke(project, first[static_cast<difference>(index)]));
+        }
+        else {
+            return std::invoke(project, first[static_cast<difference>(index)]);
+        }
+    }
+}
+
+/** Submit only the rows of a list that are visible. */
+template<std::ranges::random_access_range Range, typename Row>
+void ClipRows(Range const & elements, Row && row)
+{
+    auto const size = static_cast<std::size_t>(std::ranges::size(elements));
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(std::min<std::size_t>(size, INT_MAX)));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            PushID(i);
+            row(static_cast<std::size_t>(i));
+            PopID();
+        }
+    }
+}
+}
+
+/**
+ * \brief Models a projection from a row of a list to its text
+ *
+ * Either a function of the row's element, or of the list and the row's
+ * index, like a TextCache.
+ */
+template<typename Projection, typename Range>
+concept RowProjection = std::ranges::random_access_range<Range> and
+requires(Range const & elements, Projection const & project)
+{
+    { detail::RowText(elements, std::size_t{}, project) }
+        -> std::convertible_to<std::string_view>;
+};
+
+/**
+ * \brief A scrollbox that only projects and submits its visible rows
+ *
+ * Rows have to be the same height, so a frame costs the number of visible
+ * rows, whatever the size of the list.
+ */
+template<std::ranges::random_access_range Range,
+         RowProjection<Range> Projection = std::identity>
+requires std::ranges::sized_range<Range>
+void ClippedScrollbox(Range const & elements,
+                      Projection const & project = {},
+                      ImVec2 const & scrollbox_size = Defaults::ScrollboxSize)
+{
+    ImGui::BeginChild("Scrollbox", scrollbox_size, true);
+    detail::ClipRows(elements, [&](std::size_t i) {
+        auto && text = detail::RowText(elements, i, project);
+        std::string_view const view{ text };
+        TextUnformatted(view.data(), view.data() + view.size());
+    });
+    ImGui::EndChild();
+}
+
+template<std::ranges::random_access_range Range,
+         std::invocable<std::ranges::range_reference_t<Range const>> ValueConsumer,
+         RowProjection<Range> Projection = std::identity>
+requires std::ranges::sized_range<Range>
+void ClippedScrollbox(Range const & elements,
+                      ValueConsumer const & on_selected,
+                      Projection const & project = {},
+                      ImVec2 const & scrollbox_size = Defaults::ScrollboxSize)
+{
+    using difference = std::ranges::range_difference_t<Range>;
+    ImGui::BeginChild("Scrollbox", scrollbox_size, true);
+    detail::ClipRows(elements, [&](std::size_t i) {
+        auto && text = detail::RowText(elements, i, project);
+        std::string_view const view{ text };
+        if (ImGui::Selectable(FrameString(view))) {
+            on_selected(std::ranges::begin(elements)[static_cast<difference>(i)]);
+        }
+    });
+    ImGui::EndChild();
+}
+
+/**
+ * \brief A list of buttons that only projects and submits its visible rows
+ *
+ * Place it in a scrolling child window for the clipping to take effect.
+ */
+template<std::ranges::random_access_range Range,
+         std::invocable<std::ranges::range_reference_t<Range const>> Callback,
+         RowProjection<Range> Projection = std::identity>
+requires std::ranges::sized_range<Range>
+void ClippedButtonList(Range const & elems,
+                       Callback const & on_click,
+                       Projection const & as_text = {},
+                       ImVec2 const & button_size = Defaults::ButtonSize)
+{
+    using difference = std::ranges::range_difference_t<Range>;
+    detail::ClipRows(elems, [&](std::size_t i) {
+        auto && text = detail::RowText(elems, i, as_text);
+        std::string_view const view{ text };
+        if (Button(FrameString(view), button_size)) {
+            on_click(std::ranges::begin(elems)[static_cast<difference>(i)]);
+        }
+    });
+}
+
 struct TextView {
     std::optional<ImVec4> color = std::nullopt;
 };
@@ -98,11 +340,261 @@ struct WindowView {
 };
 bool NewWindow(WindowView const & params = {});
 
+/** A ColumnView with a Label id, which doesn't allocate */
+struct LabelColumnView {
+    Label id = "##column";
+
+    ImGuiTableColumnFlags flags = ImGuiTableColumnFlags_None;
+    float init_width = 0.f;
+};
+void TableSetupColumn(LabelColumnView const & params);
+
+/** A WindowView with a Label id, which doesn't allocate */
+struct LabelWindowView {
+    Label id = "##window";
+
+    bool * is_open = nullptr;
+    ImGuiWindowFlags flags = ImGuiWindowFlags_NoCollapse;
+    ImVec2 position = {
+        GetMainViewport()->WorkPos.x + 50,
+        GetMainViewport()->WorkPos.y + 50,
+    };
+    ImVec2 size = Defaults::WindowSize;
+};
+bool NewWindow(LabelWindowView const & params);
+
 template<std::invocable Callback>
-void Button(std::string const & text,
+void Button(Label const & text,
             Callback const & on_selected,
             ImVec2 size = ImGui::Defaults::ButtonSize)
 {
     if (Button(text.c_str(), size)) { on_selected(); }
 }
+
+/**
+ * \brief Start a table of quantile rows, with a column per statistic
+ * \return true if the table is visible; call EndTable() only if this returns
+ *         true
+ */
+inline bool BeginQuantileTable(char const * id)
+{
+    if (not BeginTable(id, 6, ImGuiTableFlags_RowBg |
+                              ImGuiTableFlags_SizingFixedFit)) {
+        return false;
+    }
+    for (char const * name : { "", "count", "p50", "p99", "p99.9", "max" }) {
+        TableSetupColumn(name);
+    }
+    TableHeadersRow();
+    return true;
+}
+
+/** Show a row of a sketch of durations, in milliseconds. */
+inline void QuantileRow(char const * label, ion::quantile_sketch const & sketch)
+{
+    auto const milliseconds = [](std::uint64_t nanoseconds) {
+        return static_cast<double>(nanoseconds) / 1'000'000.0;
+    };
+    TableNextRow();
+    TableNextColumn();
+    TextUnformatted(label);
+    TableNextColumn();
+    Text("%llu", static_cast<unsigned long long>(sketch.count()));
+    for (double const fraction : { 0.5, 0.99, 0.999 }) {
+        TableNextColumn();
+        Text("%.2f", milliseconds(sketch.quantile(fraction)));
+    }
+    TableNextColumn();
+    Text("%.2f", milliseconds(sketch.max()));
+}
+}
+
+template<typename Projection>
+template<std::ranges::random_access_range Range>
+inline std::string_view
+ImGui::TextCache<Projection>::operator()(Range const & elements,
+                                         std::size_t index) const
+{
+    auto const size = static_cast<std::size_t>(std::ranges::size(elements));
+    // rows keep their text as the list grows or shrinks at the end
+    if (cached.size() != size) {
+        texts.resize(size);
+        cached.resize(size, false);
+    }
+    if (not cached[index]) {
+        using difference = std::ranges::range_difference_t<Range>;
+        texts[index] = std::invoke(
+            project, std::ranges::begin(elements)[static_cast<difference>(index)]);
+        cached[index] = true;
+    }
+    return texts[index];
+}
+
+template<typename Projection>
+inline void ImGui::TextCache<Projection>::Invalidate(std::size_t index) const
+{
+    if (index < cached.size()) {
+        cached[index] = false;
+    }
+}
+
+namespace ImGui::detail {
+
+/**
+ * \brief Bump-allocated memory, reset at the start of each imgui frame
+ *
+ * Allocating moves a cursor through a block. When a frame outgrows its
+ * block, another one is chained on, and the next frame replaces them all
+ * with one block big enough for both.
+ */
+class FrameArena {
+public:
+    char * Allocate(std::size_t size);
+private:
+    void Reset(int frame);
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        std::size_t size = 0u;
+    };
+    std::vector<Block> blocks;
+    // the bytes used of the last block, and of every block this frame
+    std::size_t used = 0u;
+    std::size_t total = 0u;
+    int frame = -1;
+};
+
+inline FrameArena frame_arena;
+
+inline void FrameArena::Reset(int next_frame)
+{
+    frame = next_frame;
+    if (blocks.size() > 1u) {
+        std::size_t capacity = 0u;
+        for (auto const & block : blocks) {
+            capacity += block.size;
+        }
+        blocks.clear();
+        blocks.push_back({ std::make_unique<char[]>(capacity), capacity });
+    }
+    used = 0u;
+    total = 0u;
+}
+
+inline char * FrameArena::Allocate(std::size_t size)
+{
+    if (int const current = GetFrameCount(); current != frame) {
+        Reset(current);
+    }
+    if (blocks.empty() or blocks.back().size - used < size) {
+        std::size_t constexpr first_block = 4096u;
+        std::size_t const grown = blocks.empty() ? first_block
+                                                 : blocks.back().size * 2u;
+        std::size_t const capacity = std::max(grown, size);
+        blocks.push_back({ std::make_unique<char[]>(capacity), capacity });
+        used = 0u;
+    }
+    char * const memory = blocks.back().data.get() + used;
+    used += size;
+    total += size;
+    return memory;
+}
+
+/** Write an argument, returning the end of what was written. */
+template<FormatArgument T>
+char * FormatInto(char * first, char * last, T const & value)
+{
+    if constexpr (std::integral<T> or std::floating_point<T>) {
+        return std::to_chars(first, last, value).ptr;
+    }
+    else {
+        std::string_view const text{ value };
+        auto const room = static_cast<std::size_t>(last - first);
+        return std::copy_n(text.data(), std::min(text.size(), room), first);
+    }
+}
+
+/** The most characters an argument can take. */
+template<FormatArgument T>
+std::size_t FormatSize([[maybe_unused]] T const & value)
+{
+    if constexpr (std::integral<T>) {
+        return 24u;
+    }
+    else if constexpr (std::floating_point<T>) {
+        return 32u;
+    }
+    else {
+        return std::string_view{ value }.size();
+    }
+}
+}
+
+inline char * ImGui::FrameAlloc(std::size_t size)
+{
+    return detail::frame_arena.Allocate(size);
+}
+
+inline char const * ImGui::FrameString(std::string_view text)
+{
+    char * const copy = FrameAlloc(text.size() + 1u);
+    std::copy(text.begin(), text.end(), copy);
+    copy[text.size()] = '\0';
+    return copy;
+}
+
+inline char const * ImGui::Label::c_str() const
+{
+    if (is_id) {
+        // a hidden label, whose text imgui hashes into the same id each frame
+        char * const label = FrameAlloc(11u);
+        label[0] = '#';
+        label[1] = '#';
+        char * const last = label + 10;
+        std::fill(label + 2, last, '0');
+        auto const digits = std::to_chars(label + 2, last, id, 16).ptr;
+        std::rotate(label + 2, digits, last);
+        *last = '\0';
+        return label;
+    }
+    return terminated ? text.data() : FrameString(text);
+}
+
+template<ImGui::FormatString format, ImGui::FormatArgument... Args>
+requires (sizeof...(Args) == format.Placeholders())
+inline char const * ImGui::FormatLabel(Args const &... args)
+{
+    std::string_view const pattern{ format.chars, sizeof(format.chars) - 1u };
+    std::size_t const size = pattern.size()
+                           + (std::size_t{ 0u } + ... + detail::FormatSize(args));
+    char * const label = FrameAlloc(size + 1u);
+    char * out = label;
+    char * const last = label + size;
+    std::size_t offset = 0u;
+    // copy the text up to each placeholder, then the argument in its place
+    [[maybe_unused]] auto const write = [&](auto const & value) {
+        auto const placeholder = pattern.find("{}", offset);
+        out = std::copy(pattern.begin() + static_cast<std::ptrdiff_t>(offset),
+                        pattern.begin() + static_cast<std::ptrdiff_t>(placeholder),
+                        out);
+        out = detail::FormatInto(out, last, value);
+        offset = placeholder + 2u;
+    };
+    (write(args), ...);
+    out = std::copy(pattern.begin() + static_cast<std::ptrdiff_t>(offset),
+                    pattern.end(), out);
+    *out = '\0';
+    return label;
+}
+
+inline void ImGui::TableSetupColumn(LabelColumnView const & params)
+{
+    TableSetupColumn(params.id.c_str(), params.flags, params.init_width);
+}
+
+inline bool ImGui::NewWindow(LabelWindowView const & params)
+{
+    SetNextWindowPos(params.position, ImGuiCond_FirstUseEver);
+    SetNextWindowSize(params.size, ImGuiCond_FirstUseEver);
+    return Begin(params.id.c_str(), params.is_open, params.flags);
 }
@@ -3,6 +3,15 @@
 // data types and resource handles
 #include <optional>
 #include <expected>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
 
 // type constraints
 #include <concepts>
@@ -78,6 +87,48 @@ auto back_inserter_preference(container & c)
     return std::front_inserter(c);
 }
 
+/**
+ * \brief The memory resource a container allocates from
+ * \param c    a container, such as a std::pmr::vector
+ * \return the resource of a polymorphic allocator, or the default resource
+ */
+template<typename container>
+std::pmr::memory_resource * memory_resource_of(container const & c)
+{
+    if constexpr (requires {
+        { c.get_allocator().resource() }
+            -> std::convertible_to<std::pmr::memory_resource *>;
+    }) {
+        return c.get_allocator().resource();
+    }
+    else {
+        return std::pmr::get_default_resource();
+    }
+}
+
+/**
+ * \brief An empty list of yaml-exceptions that allocates like `errors`
+ * \tparam error_output     allocator-aware container of yaml-exceptions
+ *
+ * Readers gather errors into a list of their own before contextualizing them.
+ * Making that list with the allocator of `errors` keeps it in the caller's
+ * memory resource, e.g. a monotonic arena for a whole file.
+ */
+template<std::ranges::output_range<YAML::Exception> error_output>
+auto error_buffer_for(error_output const & errors)
+{
+    if constexpr (requires { errors.get_allocator(); }) {
+        using allocator = typename std::allocator_traits<
+            decltype(errors.get_allocator())>::template
+            rebind_alloc<YAML::Exception>;
+        return std::vector<YAML::Exception, allocator>(
+            allocator{ errors.get_allocator() });
+    }
+    else {
+        return std::vector<YAML::Exception>{};
+    }
+}
+
 /** The key type of map-container */
 template<typename container>
 using lookup_key_t = typename container::key_type;
@@ -127,7 +178,7 @@ void read_lookup(YAML::Node const & config,
                      back_inserter_preference(errors));
         return;
     }
-    auto const search = lookup.find(config.as<std::string>());
+    auto const search = lookup.find(config.Scalar());
     if (search != lookup.end()) {
         value = search->second;
         return;
@@ -187,6 +238,7 @@ void read(YAML::Node const & config, string_like & value, error_output & errors)
  */
 template<std::integral number,
          std::ranges::output_range<YAML::Exception> error_output>
+requires (not std::same_as<number, bool>)
 void read(YAML::Node const & config, number & value, error_output & errors)
 {
     namespace ranges = std::ranges;
@@ -198,7 +250,8 @@ void read(YAML::Node const & config, number & value, error_output & errors)
                      back_inserter_preference(errors));
         return;
     }
-    std::regex const negative_pattern{ "^-" };
+    // patterns are compiled once; matching a const regex is thread-safe
+    static std::regex const negative_pattern{ "^-" };
     if (std::is_unsigned_v<number> and
         std::regex_search(config.Scalar(), negative_pattern)) {
 
@@ -208,7 +261,7 @@ void read(YAML::Node const & config, number & value, error_output & errors)
                      back_inserter_preference(errors));
         return;
     }
-    std::regex const integer_pattern{ "-?[0-9]+[ \t]*" };
+    static std::regex const integer_pattern{ "-?[0-9]+[ \t]*" };
     if (not std::regex_match(config.Scalar(), integer_pattern)) {
         YAML::Exception const error{ config.Mark(), "expecting an integer" };
         ranges::copy(views::single(error),
@@ -218,6 +271,32 @@ void read(YAML::Node const & config, number & value, error_output & errors)
     value = config.as<number>();
 }
 
+/**
+ * \brief Read a boolean from config
+ *
+ * \tparam error_output     allocator-aware range of yaml-exceptions
+ *
+ * \param config    YAML boolean input, such as true, false, yes or no
+ * \param value     write parsed boolean to
+ * \param errors    write any parsing errors to
+ */
+template<std::ranges::output_range<YAML::Exception> error_output>
+void read(YAML::Node const & config, bool & value, error_output & errors)
+{
+    namespace ranges = std::ranges;
+    namespace views = std::views;
+
+    bool parsed = false;
+    if (not config.IsScalar() or
+        not YAML::convert<bool>::decode(config, parsed)) {
+        YAML::Exception const error{ config.Mark(), "expecting true or false" };
+        ranges::copy(views::single(error),
+                     back_inserter_preference(errors));
+        return;
+    }
+    value = parsed;
+}
+
 /**
  * \brief Read a floating point number from config
  *
@@ -240,9 +319,9 @@ void read(YAML::Node const & config, number & value, error_output & errors)
                      back_inserter_preference(errors));
         return;
     }
-    std::regex const integer_pattern{ "-?[0-9]+\\.?" };
-    std::regex const decimal_pattern{ "-?\\.[0-9]+" };
-    std::regex const real_pattern{ "-?[0-9]+\\.[0-9]+" };
+    static std::regex const integer_pattern{ "-?[0-9]+\\.?" };
+    static std::regex const decimal_pattern{ "-?\\.[0-9]+" };
+    static std::regex const real_pattern{ "-?[0-9]+\\.[0-9]+" };
 
     std::string const& scalar_value = config.Scalar();
     if (not std::regex_match(scalar_value, integer_pattern) and
@@ -268,6 +347,27 @@ requires(YAML::Node const & node, value & v, std::vector<YAML::Exception> & erro
     konbu::read(node, v, errors);
 };
 
+/**
+ * \brief Re-contextualize a yaml error from an element of a sequence
+ */
+inline YAML::Exception
+contextualize_sequence_value(YAML::Exception const & error)
+{
+    return YAML::Exception{ error.mark,
+                            "couldn't read sequence value: " + error.msg };
+}
+
+/**
+ * \brief Re-contextualize a yaml error from an element of a sequence,
+ *        reusing its message
+ */
+inline YAML::Exception
+contextualize_sequence_value(YAML::Exception && error)
+{
+    error.msg.insert(0, "couldn't read sequence value: ");
+    return YAML::Exception{ error.mark, std::move(error.msg) };
+}
+
 /**
  * \brief Parse a sequence of values
  *
@@ -299,7 +399,7 @@ void partition_expect(YAML::Node const & sequence,
         ranges::copy(views::single(error), back_inserter_preference(errors));
         return;
     }
-    std::vector<YAML::Exception> sequence_errors;
+    auto sequence_errors = error_buffer_for(errors);
     for (YAML::Node const & node : sequence) {
         value_t value;
         auto const num_errors = sequence_errors.size();
@@ -311,13 +411,131 @@ void partition_expect(YAML::Node const & sequence,
         ranges::copy(views::single(value),
                      back_inserter_preference(values));
     }
-    auto contextualize = [](YAML::Exception const & error) {
-        std::stringstream message;
-        message << "couldn't read sequence value: " << error.msg;
-        return YAML::Exception{ error.mark, message.str() };
+    ranges::transform(sequence_errors, back_inserter_preference(errors),
+                      [](YAML::Exception & error) {
+        return contextualize_sequence_value(std::move(error));
+    });
+}
+
+/**
+ * \brief A pool that can run a function over a range in parallel
+ *
+ * e.g. `ion::jobs`. `parallel_for(range, fn, grain)` calls `fn` with each
+ * element, `grain` elements per job, and returns once every call is done.
+ */
+template<typename pool_type>
+concept parallel_pool =
+requires(pool_type & pool, std::vector<std::size_t> & chunks,
+         void (*fn)(std::size_t))
+{
+    pool.parallel_for(chunks, fn, std::size_t{ 1u });
+};
+
+/**
+ * \brief Ask every node of a document for its size
+ *
+ * yaml-cpp caches the size of a node the first time it's asked for. Once
+ * every size is cached, reading the document no longer writes to it, so it
+ * can be read from several threads, even where aliases share nodes.
+ */
+inline void cache_sizes(YAML::Node const & node)
+{
+    if (node.IsSequence()) {
+        for (YAML::Node const & element : node) {
+            cache_sizes(element);
+        }
+    }
+    else if (node.IsMap()) {
+        for (auto const & pair : node) {
+            cache_sizes(pair.first);
+            cache_sizes(pair.second);
+        }
+    }
+    static_cast<void>(node.size());
+}
+
+/**
+ * \brief Parse a sequence of values in parallel
+ *
+ * \tparam pool_type        runs chunks of the sequence in parallel
+ * \tparam value_output     allocator-aware container of konbu-readable types
+ * \tparam error_output     allocator-aware container of yaml-exceptions
+ *
+ * \param pool      runs the chunks
+ * \param sequence  YAML sequence input of desired values
+ * \param values    write parsed values to
+ * \param errors    write any parsing errors to
+ * \param grain     elements per chunk, or 0 to pick one
+ *
+ * Each chunk of the sequence is read into its own values and errors, which
+ * are then appended in order, so the results are the same as the serial
+ * `partition_expect`. Chunks keep the errors of their readers as they are,
+ * and the sequence context is only formatted on the calling thread, as each
+ * error is appended to `errors`.
+ *
+ * \note Elements are read from several threads at once. The sizes of every
+ *       node are cached first with `cache_sizes`, so that reading doesn't
+ *       write to the document. Nothing else may read or modify the document
+ *       until the call returns.
+ */
+template<parallel_pool pool_type,
+         std::ranges::range value_output,
+         std::ranges::output_range<YAML::Exception> error_output>
+requires readable<std::ranges::range_value_t<value_output>>
+
+void partition_expect(pool_type & pool,
+                      YAML::Node const & sequence,
+                      value_output & values,
+                      error_output & errors,
+                      std::size_t grain = 0u)
+{
+    namespace ranges = std::ranges;
+    namespace views = std::views;
+    using value_t = ranges::range_value_t<value_output>;
+
+    if (not sequence.IsSequence()) {
+        YAML::Exception const error{ sequence.Mark(), "expecting a sequence" };
+        ranges::copy(views::single(error), back_inserter_preference(errors));
+        return;
+    }
+    cache_sizes(sequence);
+    // sequence iterators only go forward, so gather the nodes up front
+    std::vector<YAML::Node> const nodes(sequence.begin(), sequence.end());
+    if (grain == 0u) {
+        grain = std::max<std::size_t>(nodes.size() / 64u, 64u);
+    }
+    // the chunks are filled on other threads, so they use the default
+    // resource rather than the outputs', which may not be thread-safe
+    struct chunk_output {
+        std::vector<value_t> values;
+        std::vector<YAML::Exception> errors;
     };
-    ranges::copy(sequence_errors | views::transform(contextualize),
-                 back_inserter_preference(errors));
+    std::size_t const chunk_count = (nodes.size() + grain - 1u) / grain;
+    std::vector<chunk_output> outputs(chunk_count);
+    std::vector<std::size_t> chunks(chunk_count);
+    for (std::size_t i = 0u; i < chunk_count; ++i) {
+        chunks[i] = i;
+    }
+    pool.parallel_for(chunks, [&nodes, &outputs, grain](std::size_t chunk) {
+        auto & [chunk_values, chunk_errors] = outputs[chunk];
+        std::size_t const end = std::min(chunk * grain + grain, nodes.size());
+        for (std::size_t i = chunk * grain; i < end; ++i) {
+            value_t value;
+            auto const num_errors = chunk_errors.size();
+            konbu::read(nodes[i], value, chunk_errors);
+            if (chunk_errors.size() == num_errors) {
+                chunk_values.push_back(std::move(value));
+            }
+        }
+    }, 1u);
+
+    for (auto & [chunk_values, chunk_errors] : outputs) {
+        ranges::move(chunk_values, back_inserter_preference(values));
+        ranges::transform(chunk_errors, back_inserter_preference(errors),
+                          [](YAML::Exception & error) {
+            return contextualize_sequence_value(std::move(error));
+        });
+    }
 }
 
 /**
@@ -365,7 +583,7 @@ void read_flags(YAML::Node const & flagname_sequence,
         return false;
     };
     // partition algorithm
-    std::vector<YAML::Exception> flagname_errors;
+    auto flagname_errors = error_buffer_for(errors);
     for (YAML::Node const & node : flagname_sequence) {
 
         std::string name;
@@ -403,6 +621,131 @@ void read_flags(YAML::Node const & flagname_sequence,
                  back_inserter_preference(errors));
 }
 
+/**
+ * \brief A flag name and the bits it stands for
+ * \tparam bits     unsigned integer type of the flags
+ */
+template<std::unsigned_integral bits>
+struct flag_name {
+    std::string_view name;
+    bits value;
+};
+
+/**
+ * \brief A fixed table of flag names, e.g. a constexpr std::array of flag_name
+ * \tparam table    range of elements with a `name` and unsigned `value`
+ */
+template<typename table>
+concept flag_table =
+std::ranges::forward_range<table const> and
+requires(std::ranges::range_value_t<table> const & flag)
+{
+    { flag.name } -> std::convertible_to<std::string_view>;
+    requires std::unsigned_integral<std::remove_cvref_t<decltype(flag.value)>>;
+};
+
+/** The flag type of a flag table */
+template<flag_table table>
+using flag_bits_t = std::remove_cvref_t<
+    decltype(std::declval<std::ranges::range_value_t<table> const &>().value)>;
+
+/**
+ * \brief Read flag values from a config node, using a fixed table of names
+ *
+ * \tparam table                a flag_table
+ * \tparam error_output         allocator-aware container of yaml-exceptions
+ *
+ * \param flagname_sequence     YAML input sequence of desired values
+ * \param flags                 write parsed flags to
+ * \param names                 the flag names and their values
+ * \param errors                write any parsing errors to
+ *
+ * Behaves as the lookup-table `read_flags`, but each scalar is compared in
+ * place against the names of `table`, so reading valid flags doesn't allocate.
+ * Elements that aren't flag names are marked in a bitset per block of 64, and
+ * their errors are only made after the block is read.
+ */
+template<flag_table table,
+         std::ranges::output_range<YAML::Exception> error_output>
+void read_flags(YAML::Node const & flagname_sequence,
+                flag_bits_t<table> & flags,
+                table const & names,
+                error_output & errors)
+{
+    namespace ranges = std::ranges;
+    namespace views = std::views;
+
+    if (not flagname_sequence.IsSequence()) {
+        YAML::Exception const error{ flagname_sequence.Mark(),
+                                     "expecting a sequence" };
+        ranges::copy(views::single(error), back_inserter_preference(errors));
+        return;
+    }
+    constexpr std::size_t block_size = 64u;
+    std::string expected_names;
+    auto const report = [&](std::size_t first,
+                            std::uint64_t not_strings,
+                            std::uint64_t unknown) {
+        for (auto bits = not_strings | unknown; bits != 0u; bits &= bits - 1u) {
+            auto const bit = static_cast<std::size_t>(std::countr_zero(bits));
+            YAML::Node const node = flagname_sequence[first + bit];
+
+            std::string message = "couldn't parse flag: ";
+            if ((not_strings >> bit) & 1u) {
+                message += "expecting a string";
+            }
+            else {
+                if (expected_names.empty()) {
+                    for (auto const & flag : names) {
+                        if (not expected_names.empty()) {
+                            expected_names += ", ";
+                        }
+                        expected_names += std::string_view{ flag.name };
+                    }
+                }
+                message += "no flag named \"" + node.Scalar() + "\"\n  "
+                           "expecting name to be one of the following: ["
+                         + expected_names + "]";
+            }
+            YAML::Exception const error{ node.Mark(), message };
+            ranges::copy(views::single(error),
+                         back_inserter_preference(errors));
+        }
+    };
+    auto const name_of = [](auto const & flag) {
+        return std::string_view{ flag.name };
+    };
+
+    flag_bits_t<table> parsed_flags = 0u;
+    std::size_t index = 0u;
+    std::uint64_t not_strings = 0u;
+    std::uint64_t unknown = 0u;
+    for (YAML::Node const & node : flagname_sequence) {
+        auto const bit = std::uint64_t{ 1u } << (index % block_size);
+        if (not node.IsScalar()) {
+            not_strings |= bit;
+        }
+        else if (auto const search = ranges::find(
+                     names, std::string_view{ node.Scalar() }, name_of);
+                 search != ranges::end(names)) {
+            parsed_flags |= search->value;
+        }
+        else {
+            unknown |= bit;
+        }
+        if (++index % block_size == 0u) {
+            report(index - block_size, not_strings, unknown);
+            not_strings = 0u;
+            unknown = 0u;
+        }
+    }
+    report(index - index % block_size, not_strings, unknown);
+
+    if (parsed_flags != 0u) {
+        flags = parsed_flags;
+    }
+}
+
 template<typename value>
 concept string_streamable =
 requires(std::stringstream & stream, value const & v) {
@@ -0,0 +1,39 @@
+#include "gold/compact.hpp"
+#include <entt/entity/registry.hpp>
+#include <vector>
+
+namespace {
+template<typename from_component, typename to_component, typename convert>
+void convert_all(entt::registry & widgets, convert const & as_component)
+{
+    auto const view = widgets.view<from_component>();
+    std::vector<entt::entity> const converted(view.begin(), view.end());
+    for (auto const widget : converted) {
+        auto const & value = widgets.get<from_component>(widget);
+        widgets.emplace_or_replace<to_component>(widget, as_component(value));
+        widgets.erase<from_component>(widget);
+    }
+}
+}
+
+void gold::compact(entt::registry & widgets)
+{
+    auto const as_compact = [](auto const & value) {
+        return gold::compact(value);
+    };
+    convert_all<gold::layout, gold::compact_layout>(widgets, as_compact);
+    convert_all<gold::size, gold::compact_size>(widgets, as_compact);
+    convert_all<gold::background_color,
+                gold::compact_background_color>(widgets, as_compact);
+}
+
+void gold::expand(entt::registry & widgets)
+{
+    auto const as_expanded = [](auto const & value) {
+        return gold::expand(value);
+    };
+    convert_all<gold::compact_layout, gold::layout>(widgets, as_expanded);
+    convert_all<gold::compact_size, gold::size>(widgets, as_expanded);
+    convert_all<gold::compact_background_color,
+                gold::background_color>(widgets, as_expanded);
+}
@@ -0,0 +1,161 @@
+#include "gold/component_registry.hpp"
+
+#include <entt/entity/registry.hpp>
+#include <yaml-cpp/yaml.h>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace {
+// spread hashes that are poor in their top bits, like integer identities
+std::uint64_t mix(std::uint64_t hash)
+{
+    return hash * 0x9e3779b97f4a7c15u;
+}
+}
+
+std::size_t gold::component_registry::find_id_slot(entt::id_type id) const
+{
+    std::size_t const mask = id_slots.size() - 1u;
+    auto index = static_cast<std::size_t>(mix(id) >> shift);
+    while (id_slots[index] != no_entry and entries[id_slots[index]].id != id) {
+        index = (index + 1u) & mask;
+    }
+    return index;
+}
+
+std::size_t
+gold::component_registry::find_key_slot(std::string_view key) const
+{
+    std::size_t const mask = key_slots.size() - 1u;
+    auto const hash = std::hash<std::string_view>{}(key);
+    auto index = static_cast<std::size_t>(mix(hash) >> shift);
+    while (key_slots[index].entry != no_entry and key_slots[index].key != key) {
+        index = (index + 1u) & mask;
+    }
+    return index;
+}
+
+auto gold::component_registry::find_key_entry(std::string_view key) const
+    -> key_slot const *
+{
+    if (key_slots.empty()) {
+        return nullptr;
+    }
+    auto const & slot = key_slots[find_key_slot(key)];
+    return slot.entry == no_entry ? nullptr : &slot;
+}
+
+void gold::component_registry::rehash(std::size_t capacity)
+{
+    auto previous_ids = std::exchange(id_slots,
+                                      std::vector<std::size_t>(capacity, no_entry));
+    auto previous_keys = std::exchange(key_slots,
+                                       std::vector<key_slot>(capacity));
+    shift = 64u - static_cast<unsigned>(std::countr_zero(capacity));
+    for (std::size_t const index : previous_ids) {
+        if (index != no_entry) {
+            id_slots[find_id_slot(entries[index].id)] = index;
+        }
+    }
+    for (key_slot & slot : previous_keys) {
+        if (slot.entry != no_entry) {
+            key_slots[find_key_slot(slot.key)] = std::move(slot);
+        }
+    }
+}
+
+std::size_t gold::component_registry::add(gold::component_entry entry)
+{
+    if (auto const * found = find(entry.id)) {
+        return static_cast<std::size_t>(found - entries.data());
+    }
+    // keep the tables at most 3/4 full, so probes stay short
+    std::size_t const used = std::max(entries.size() + 1u,
+                                      key_count + entry.keys.size());
+    if (used * 4u > id_slots.size() * 3u) {
+        rehash(std::bit_ceil(std::max<std::size_t>(used + used / 3u + 1u,
+                                                   8u)));
+    }
+    std::size_t const index = entries.size();
+    id_slots[find_id_slot(entry.id)] = index;
+    for (std::size_t rank = 0u; rank < entry.keys.size(); ++rank) {
+        auto & slot = key_slots[find_key_slot(entry.keys[rank])];
+        if (slot.entry == no_entry) {
+            slot = { entry.keys[rank], index, rank };
+            ++key_count;
+        }
+    }
+    entries.push_back(std::move(entry));
+    return index;
+}
+
+gold::component_entry const *
+gold::component_registry::find(entt::id_type id) const
+{
+    if (id_slots.empty()) {
+        return nullptr;
+    }
+    std::size_t const index = id_slots[find_id_slot(id)];
+    return index == no_entry ? nullptr : &entries[index];
+}
+
+gold::component_entry const *
+gold::component_registry::find_key(std::string_view key) const
+{
+    auto const * slot = find_key_entry(key);
+    return slot ? &entries[slot->entry] : nullptr;
+}
+
+void gold::component_registry::read_entries(
+    YAML::Node const & config, entt::registry & widgets, entt::entity widget,
+    std::pmr::vector<YAML::Exception> & errors) const
+{
+    if (not config.IsMap()) {
+        errors.emplace_back(config.Mark(), "expecting a map");
+        return;
+    }
+    // the configured key of highest precedence of each entry,
+    // unknown keys are ignored, the same as when reading a component set
+    struct chosen_key {
+        YAML::Node config;
+        std::size_t rank = no_entry;
+    };
+    std::pmr::vector<chosen_key> chosen{ entries.size(),
+                                         errors.get_allocator() };
+    for (auto const & setting : config) {
+        auto const * slot = find_key_entry(setting.first.Scalar());
+        if (slot and slot->rank < chosen[slot->entry].rank) {
+            chosen[slot->entry] = { setting.second, slot->rank };
+        }
+    }
+    for (std::size_t index = 0u; index < entries.size(); ++index) {
+        if (chosen[index].rank != no_entry and entries[index].reader) {
+            entries[index].reader(chosen[index].config,
+                                  widgets, widget, errors);
+        }
+    }
+}
+
+void gold::component_registry::write(YAML::Emitter & out,
+                                     entt::registry const & widgets,
+                                     entt::entity widget) const
+{
+    for (gold::component_entry const & entry : entries) {
+        if (entry.writer) {
+            entry.writer(out, widgets, widget);
+        }
+    }
+}
+
+void gold::component_registry::show_options(entt::registry & widgets,
+                                            entt::entity widget) const
+{
+    for (gold::component_entry const & entry : entries) {
+        if (entry.editor) {
+            entry.editor(widgets, widget);
+        }
+    }
+}
@@ -2,9 +2,12 @@
 #include "gold/background_color.hpp"
 #include "gold/size.hpp"
 #include "gold/layout.hpp"
+#include "gold/compact.hpp"
+#include "gold/style.hpp"
 
 #include "imgui/imgui.h"
 #include <entt/entity/registry.hpp>
+#include <optional>
 
 namespace align = gold::align;
 void gold::align_cursor(gold::size size, align::horizontal halign,
@@ -58,16 +61,55 @@ void gold::align_cursor(gold::size size, align::vertical valign,
     }
 }
 
-void gold::render(entt::registry & widgets, entt::entity widget)
+namespace {
+// widgets may have their own, shared or compact components. Only the compact
+// color is used as it's packed; half floats have no arithmetic, so compact
+// sizes are decoded, and compact layouts are unpacked into their two enums.
+bool push_background_color(entt::registry const & widgets, entt::entity widget)
 {
-    auto const * color = widgets.try_get<gold::background_color>(widget);
-    if (color) {
+    using color_type = gold::background_color;
+    if (auto const * color = gold::try_get_style<color_type>(widgets, widget)) {
         ImGui::PushStyleColor(ImGuiCol_ChildBg, color->vector());
+        return true;
+    }
+    using compact_color = gold::compact_background_color;
+    if (auto const * color = widgets.try_get<compact_color>(widget)) {
+        ImGui::PushStyleColor(ImGuiCol_ChildBg, color->rgba);
+        return true;
+    }
+    return false;
+}
+std::optional<gold::size>
+find_size(entt::registry const & widgets, entt::entity widget)
+{
+    if (auto const * size = gold::try_get_style<gold::size>(widgets, widget)) {
+        return *size;
+    }
+    if (auto const * size = widgets.try_get<gold::compact_size>(widget)) {
+        return gold::expand(*size);
     }
+    return std::nullopt;
+}
+std::optional<gold::layout>
+find_layout(entt::registry const & widgets, entt::entity widget)
+{
+    if (auto const * layout = widgets.try_get<gold::layout>(widget)) {
+        return *layout;
+    }
+    if (auto const * layout = widgets.try_get<gold::compact_layout>(widget)) {
+        return gold::expand(*layout);
+    }
+    return std::nullopt;
+}
+}
+
+void gold::render(entt::registry & widgets, entt::entity widget)
+{
+    bool const has_color = push_background_color(widgets, widget);
     auto const id = std::to_string(static_cast<std::uint32_t>(widget));
-    if (auto const * size = widgets.try_get<gold::size>(widget)) {
+    if (auto const size = find_size(widgets, widget)) {
         auto desired_size = size->vector();
-        if (auto const * layout = widgets.try_get<gold::layout>(widget)) {
+        if (auto const layout = find_layout(widgets, widget)) {
             align_cursor(*size, layout->horizontal, desired_size);
             align_cursor(*size, layout->vertical, desired_size);
         }
@@ -76,7 +118,7 @@ void gold::render(entt::registry & widgets, entt::entity widget)
     else {
         ImGui::BeginChild(id.c_str());
     }
-    if (color) {
+    if (has_color) {
         ImGui::PopStyleColor();
     }
     ImGui::EndChild();
@@ -0,0 +1,215 @@
+#include "gold/snapshot.hpp"
+#include "gold/widget.hpp"
+#include "gold/style.hpp"
+#include "gold/style_sheet.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <entt/entity/registry.hpp>
+#include <entt/entity/snapshot.hpp>
+
+namespace fs = std::filesystem;
+namespace {
+// identifies the buffer as a gold snapshot, and the layout of its components
+std::uint32_t constexpr snapshot_magic = 0x646c6f67u; // "gold"
+// version 2 added compact components, version 3 added shared styles
+std::uint32_t constexpr snapshot_version = 3u;
+std::size_t constexpr header_size = 2u * sizeof(std::uint32_t);
+
+// a style pool is archived as its number of handles, then the value and use
+// count of each handle
+template<gold::style_value component>
+void save_styles(entt::registry const & widgets,
+                 gold::binary_output_archive & output)
+{
+    auto const * styles = widgets.ctx().find<gold::style_pool<component>>();
+    auto const count =
+        static_cast<std::uint32_t>(styles ? styles->handle_count() : 0u);
+    output.value(count);
+    for (gold::style_handle handle = 0u; handle < count; ++handle) {
+        output.value(styles->get(handle));
+        output.value(styles->use_count(handle));
+    }
+}
+
+template<gold::style_value component>
+bool load_styles(gold::binary_input_archive & input, entt::registry & widgets)
+{
+    std::uint32_t count = 0u;
+    input.value(count);
+    std::vector<component> values;
+    std::vector<std::uint32_t> uses;
+    // a corrupt count fails on the first read past the end of the buffer
+    for (std::uint32_t handle = 0u; handle < count and input.ok(); ++handle) {
+        input.value(values.emplace_back());
+        input.value(uses.emplace_back());
+    }
+    if (not input.ok()) {
+        return false;
+    }
+    if (count != 0u or widgets.ctx().contains<gold::style_pool<component>>()) {
+        gold::styles<component>(widgets).assign(values, uses);
+    }
+    for (auto const widget : widgets.view<gold::shared<component>>()) {
+        if (widgets.get<gold::shared<component>>(widget).handle >= count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// archive the widget components the widgets set themselves, leaving out the
+// ones a style sheet applied, which are applied again when restyled. The
+// loader reads them back the same as a whole component set.
+void save_own_components(entt::snapshot const & snapshot,
+                         entt::registry const & widgets,
+                         gold::binary_output_archive & output)
+{
+    gold::widget_components::for_each(
+        [&snapshot, &widgets, &output]
+        <typename component, std::size_t index>()
+    {
+        std::vector<entt::entity> owners;
+        for (auto const widget : widgets.view<component>()) {
+            auto const * style = widgets.try_get<gold::computed_style>(widget);
+            if (not style or not style->applies(index)) {
+                owners.push_back(widget);
+            }
+        }
+        snapshot.component<component>(output, owners.begin(), owners.end());
+    });
+}
+
+// load the archived widgets after the header, into an empty registry
+bool load_widgets(gold::binary_input_archive & input, entt::registry & widgets)
+{
+    entt::snapshot_loader const loader{ widgets };
+    loader.entities(input);
+    gold::widget_components::archive(loader, input);
+    gold::compact_widget_components::archive(loader, input);
+    loader.component<gold::shared<gold::size>,
+                     gold::shared<gold::background_color>>(input);
+    loader.orphans();
+    return input.ok() and load_styles<gold::size>(input, widgets)
+                      and load_styles<gold::background_color>(input, widgets);
+}
+}
+
+gold::binary_output_archive::binary_output_archive(gold::snapshot_bytes & bytes)
+    : _bytes{ &bytes }
+{
+}
+void gold::binary_output_archive::operator()(
+    std::underlying_type_t<entt::entity> count)
+{
+    write(&count, sizeof(count));
+}
+void gold::binary_output_archive::operator()(entt::entity entity)
+{
+    write(&entity, sizeof(entity));
+}
+void gold::binary_output_archive::write(void const * data, std::size_t size)
+{
+    auto const offset = _bytes->size();
+    _bytes->resize(offset + size);
+    std::memcpy(_bytes->data() + offset, data, size);
+}
+
+gold::binary_input_archive::binary_input_archive(
+    gold::snapshot_bytes const & bytes, std::size_t offset)
+    : _bytes{ &bytes }, _offset{ offset }
+{
+}
+void gold::binary_input_archive::operator()(
+    std::underlying_type_t<entt::entity> & count)
+{
+    read(&count, sizeof(count));
+}
+void gold::binary_input_archive::operator()(entt::entity & entity)
+{
+    read(&entity, sizeof(entity));
+}
+void gold::binary_input_archive::read(void * data, std::size_t size)
+{
+    if (_failed or _offset + size > _bytes->size()) {
+        std::memset(data, 0, size);
+        _failed = true;
+        return;
+    }
+    std::memcpy(data, _bytes->data() + _offset, size);
+    _offset += size;
+}
+
+void gold::save_snapshot(entt::registry const & widgets,
+                         gold::snapshot_bytes & bytes)
+{
+    bytes.clear();
+    gold::binary_output_archive output{ bytes };
+    output(snapshot_magic);
+    output(snapshot_version);
+
+    entt::snapshot const snapshot{ widgets };
+    snapshot.entities(output);
+    save_own_components(snapshot, widgets, output);
+    gold::compact_widget_components::archive(snapshot, output);
+    snapshot.component<gold::shared<gold::size>,
+                       gold::shared<gold::background_color>>(output);
+    save_styles<gold::size>(widgets, output);
+    save_styles<gold::background_color>(widgets, output);
+}
+
+bool gold::load_snapshot(gold::snapshot_bytes const & bytes,
+                         entt::registry & widgets)
+{
+    gold::binary_input_archive input{ bytes };
+    std::uint32_t magic = 0u;
+    std::uint32_t version = 0u;
+    input(magic);
+    input(version);
+    if (not input.ok() or magic != snapshot_magic
+                       or version != snapshot_version) {
+        return false;
+    }
+    // a truncated buffer is only found partway through loading, so check it
+    // against a scratch registry before touching the widgets. The widgets
+    // are loaded in place, rather than swapped with the scratch registry, so
+    // they keep their context and any connected signals.
+    if (entt::registry scratch; not load_widgets(input, scratch)) {
+        return false;
+    }
+    gold::binary_input_archive checked{ bytes, header_size };
+    // the loader expects an empty registry to restore entities as a whole
+    widgets.clear();
+    return load_widgets(checked, widgets);
+}
+
+bool gold::save_snapshot(fs::path const & path,
+                         entt::registry const & widgets)
+{
+    gold::snapshot_bytes bytes;
+    save_snapshot(widgets, bytes);
+
+    std::ofstream file{ path, std::ios_base::binary | std::ios_base::trunc };
+    if (not file) {
+        return false;
+    }
+    file.write(reinterpret_cast<char const *>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+    return file.good();
+}
+
+bool gold::load_snapshot(fs::path const & path, entt::registry & widgets)
+{
+    std::ifstream file{ path, std::ios_base::binary };
+    if (not file) {
+        return false;
+    }
+    gold::snapshot_bytes bytes(fs::file_size(path));
+    file.read(reinterpret_cast<char *>(bytes.data()),
+              static_cast<std::streamsize>(bytes.size()));
+    if (not file) {
+        return false;
+    }
+    return load_snapshot(bytes, widgets);
+}
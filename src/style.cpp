@@ -0,0 +1,27 @@
+#include "gold/style.hpp"
+#include <cmath>
+
+namespace {
+// combine hashes the same way as boost::hash_combine
+std::size_t combine(std::size_t seed, std::size_t value)
+{
+    return seed ^ (value + 0x9e3779b9u + (seed << 6u) + (seed >> 2u));
+}
+std::size_t quantize(float value, float steps)
+{
+    return static_cast<std::size_t>(std::lround(value * steps));
+}
+}
+
+std::size_t gold::style_key(gold::size const & size)
+{
+    return combine(quantize(size.width, 1.f), quantize(size.height, 1.f));
+}
+
+std::size_t gold::style_key(gold::background_color const & color)
+{
+    std::size_t key = quantize(color.red, 255.f);
+    key = combine(key, quantize(color.green, 255.f));
+    key = combine(key, quantize(color.blue, 255.f));
+    return combine(key, quantize(color.alpha, 255.f));
+}
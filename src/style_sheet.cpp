@@ -0,0 +1,349 @@
+#include "gold/style_sheet.hpp"
+#include "gold/widget.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <vector>
+#include <entt/entity/registry.hpp>
+
+namespace ranges = std::ranges;
+
+std::expected<gold::style_names, std::string>
+gold::style_names::parse(std::string_view text)
+{
+    auto parsed = gold::selector::parse(text);
+    if (not parsed or parsed->parts.size() != 1) {
+        return std::unexpected(
+            R"(expecting names of the form "tag.class.class")");
+    }
+    auto & compound = parsed->parts.front();
+    gold::style_names names;
+    names.tag = compound.tag == "*" ? std::string{} : std::move(compound.tag);
+    names.classes = std::move(compound.classes);
+    return names;
+}
+
+bool gold::style_names::has_class(std::string_view name) const
+{
+    return ranges::find(classes, name) != classes.end();
+}
+
+bool gold::compound_selector::matches(gold::style_names const & names) const
+{
+    if (not tag.empty() and tag != "*" and tag != names.tag) {
+        return false;
+    }
+    return ranges::all_of(classes, [&names](std::string const & name) {
+        return names.has_class(name);
+    });
+}
+
+namespace {
+bool is_name_char(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) or c == '-' or c == '_';
+}
+std::string_view read_name(std::string_view & text)
+{
+    auto const end = ranges::find_if_not(text, is_name_char);
+    auto const length = static_cast<std::size_t>(end - text.begin());
+    auto const name = text.substr(0, length);
+    text.remove_prefix(length);
+    return name;
+}
+void skip_space(std::string_view & text)
+{
+    while (not text.empty() and
+           std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+}
+}
+
+std::expected<gold::selector, std::string>
+gold::selector::parse(std::string_view text)
+{
+    gold::selector parsed;
+    skip_space(text);
+    while (not text.empty()) {
+        gold::compound_selector compound;
+        if (text.front() == '*') {
+            compound.tag = "*";
+            text.remove_prefix(1);
+        }
+        else {
+            compound.tag = read_name(text);
+        }
+        while (not text.empty() and text.front() == '.') {
+            text.remove_prefix(1);
+            auto const name = read_name(text);
+            if (name.empty()) {
+                return std::unexpected("expecting a class name after \".\"");
+            }
+            compound.classes.emplace_back(name);
+        }
+        if (compound.tag.empty() and compound.classes.empty()) {
+            return std::unexpected("expecting a tag or class name");
+        }
+        parsed.parts.push_back(std::move(compound));
+
+        bool const had_space = not text.empty() and
+                               std::isspace(static_cast<unsigned char>(
+                                   text.front()));
+        skip_space(text);
+        if (text.empty()) {
+            break;
+        }
+        if (text.front() == '>') {
+            text.remove_prefix(1);
+            skip_space(text);
+            parsed.combinators.push_back(gold::combinator::child);
+        }
+        else if (had_space) {
+            parsed.combinators.push_back(gold::combinator::descendant);
+        }
+        else {
+            return std::unexpected("unexpected character \"" +
+                                   std::string{ text.front() } + "\"");
+        }
+        if (text.empty()) {
+            return std::unexpected("expecting a selector after \">\"");
+        }
+    }
+    if (parsed.parts.empty()) {
+        return std::unexpected("expecting a selector");
+    }
+    return parsed;
+}
+
+std::uint32_t gold::selector::specificity() const
+{
+    std::uint32_t classes = 0u;
+    std::uint32_t tags = 0u;
+    for (auto const & part : parts) {
+        classes += static_cast<std::uint32_t>(part.classes.size());
+        tags += part.tag.empty() or part.tag == "*" ? 0u : 1u;
+    }
+    return (classes << 8u) | tags;
+}
+
+namespace {
+// a destroyed parent is the same as none
+entt::entity parent_of(entt::registry const & widgets, entt::entity widget)
+{
+    auto const * parent = widgets.try_get<gold::parent>(widget);
+    if (not parent or not widgets.valid(parent->widget)) {
+        return entt::null;
+    }
+    return parent->widget;
+}
+bool matches_part(gold::compound_selector const & part,
+                  entt::registry const & widgets, entt::entity widget)
+{
+    auto const * names = widgets.try_get<gold::style_names>(widget);
+    return names and part.matches(*names);
+}
+// match parts [0, count) against the ancestors of widget, backtracking over
+// descendant combinators so that every possible ancestor is considered
+bool matches_ancestors(gold::selector const & selector, std::size_t count,
+                       entt::registry const & widgets, entt::entity widget)
+{
+    if (count == 0) {
+        return true;
+    }
+    auto const & part = selector.parts[count - 1];
+    auto ancestor = parent_of(widgets, widget);
+    if (selector.combinators[count - 1] == gold::combinator::child) {
+        return ancestor != entt::null
+           and matches_part(part, widgets, ancestor)
+           and matches_ancestors(selector, count - 1, widgets, ancestor);
+    }
+    for (; ancestor != entt::null; ancestor = parent_of(widgets, ancestor)) {
+        if (matches_part(part, widgets, ancestor) and
+            matches_ancestors(selector, count - 1, widgets, ancestor)) {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+bool gold::selector::matches(entt::registry const & widgets,
+                             entt::entity widget) const
+{
+    return matches_part(parts.back(), widgets, widget)
+       and matches_ancestors(*this, parts.size() - 1, widgets, widget);
+}
+
+std::vector<std::uint32_t>
+gold::style_sheet::match(entt::registry const & widgets, entt::entity widget,
+                         gold::style_names const & names) const
+{
+    // only gather the rules indexed by the widget's own names
+    std::vector<std::uint32_t> candidates = universal;
+    if (auto const search = by_tag.find(names.tag); search != by_tag.end()) {
+        ranges::copy(search->second, std::back_inserter(candidates));
+    }
+    for (auto const & name : names.classes) {
+        if (auto const search = by_class.find(name); search != by_class.end()) {
+            ranges::copy(search->second, std::back_inserter(candidates));
+        }
+    }
+    ranges::sort(candidates);
+    auto const duplicates = ranges::unique(candidates);
+    candidates.erase(duplicates.begin(), duplicates.end());
+
+    std::erase_if(candidates, [this, &widgets, widget](std::uint32_t index) {
+        return not rules[index].target.matches(widgets, widget);
+    });
+    // later rules win between rules of the same specificity
+    ranges::stable_sort(candidates, {}, [this](std::uint32_t index) {
+        return rules[index].specificity;
+    });
+    return candidates;
+}
+
+bool gold::style_sheet::is_current(gold::computed_style const & style) const
+{
+    if (style.stale or style.version < structure_version) {
+        return false;
+    }
+    return ranges::all_of(style.rules, [this, &style](std::uint32_t index) {
+        return rules[index].version <= style.version;
+    });
+}
+
+void gold::style_sheet::apply(entt::registry & widgets, entt::entity widget,
+                              gold::computed_style & style) const
+{
+    static_assert(gold::widget_components::size <= 64u);
+    gold::widget_components::for_each(
+        [this, &widgets, widget, &style]
+        <typename component, std::size_t index>()
+    {
+        auto const bit = std::uint64_t{ 1u } << index;
+        // the widget's own components override the style sheet
+        if (widgets.all_of<component>(widget) and not (style.applied & bit)) {
+            return;
+        }
+        component const * value = nullptr;
+        for (auto const rule : style.rules) {
+            auto const entity = rules[rule].declarations;
+            if (auto const * declared = declarations.try_get<component>(entity)) {
+                value = declared;
+            }
+        }
+        if (value) {
+            widgets.emplace_or_replace<component>(widget, *value);
+            style.applied |= bit;
+        }
+        else if (style.applied & bit) {
+            widgets.remove<component>(widget);
+            style.applied &= ~bit;
+        }
+    });
+}
+
+namespace {
+// widgets whose names or parent changed since the last restyle, so that
+// their descendants are restyled too
+struct changed_widgets {
+    std::vector<entt::entity> widgets;
+};
+
+bool has_changed_ancestor(entt::registry const & widgets, entt::entity widget,
+                          std::vector<entt::entity> const & changed)
+{
+    // compare the parent before checking it's valid, since a destroyed
+    // widget may be the one that changed
+    auto const * parent = widgets.try_get<gold::parent>(widget);
+    while (parent and parent->widget != entt::null) {
+        if (ranges::binary_search(changed, parent->widget)) {
+            return true;
+        }
+        if (not widgets.valid(parent->widget)) {
+            return false;
+        }
+        parent = widgets.try_get<gold::parent>(parent->widget);
+    }
+    return false;
+}
+
+void invalidate_descendants(entt::registry & widgets)
+{
+    auto * changed = widgets.ctx().find<changed_widgets>();
+    if (not changed or changed->widgets.empty()) {
+        return;
+    }
+    ranges::sort(changed->widgets);
+    for (auto const widget : widgets.view<gold::computed_style>()) {
+        if (has_changed_ancestor(widgets, widget, changed->widgets)) {
+            widgets.get<gold::computed_style>(widget).stale = true;
+        }
+    }
+    changed->widgets.clear();
+}
+}
+
+void gold::style_sheet::restyle(entt::registry & widgets) const
+{
+    invalidate_descendants(widgets);
+    // widgets that lost their names lose what the cascade applied to them
+    std::vector<entt::entity> unnamed;
+    for (auto const widget : widgets.view<gold::computed_style>()) {
+        if (not widgets.all_of<gold::style_names>(widget)) {
+            unnamed.push_back(widget);
+        }
+    }
+    for (auto const widget : unnamed) {
+        auto & style = widgets.get<gold::computed_style>(widget);
+        style.rules.clear();
+        apply(widgets, widget, style);
+        widgets.erase<gold::computed_style>(widget);
+    }
+    for (auto const widget : widgets.view<gold::style_names>()) {
+        auto & style = widgets.get_or_emplace<gold::computed_style>(widget);
+        if (is_current(style)) {
+            continue;
+        }
+        auto const & names = widgets.get<gold::style_names>(widget);
+        style.rules = match(widgets, widget, names);
+        apply(widgets, widget, style);
+        style.version = version;
+        style.stale = false;
+    }
+}
+
+void gold::style_sheet::invalidate(entt::registry & widgets,
+                                   entt::entity widget)
+{
+    if (auto * style = widgets.try_get<gold::computed_style>(widget)) {
+        style->stale = true;
+    }
+    // descendants are found once per restyle, rather than once per change
+    auto * changed = widgets.ctx().find<changed_widgets>();
+    if (not changed) {
+        changed = &widgets.ctx().emplace<changed_widgets>();
+    }
+    changed->widgets.push_back(widget);
+}
+
+void gold::style_sheet::watch(entt::registry & widgets)
+{
+    widgets.on_construct<gold::style_names>().connect<&invalidate>();
+    widgets.on_update<gold::style_names>().connect<&invalidate>();
+    widgets.on_destroy<gold::style_names>().connect<&invalidate>();
+    widgets.on_construct<gold::parent>().connect<&invalidate>();
+    widgets.on_update<gold::parent>().connect<&invalidate>();
+    widgets.on_destroy<gold::parent>().connect<&invalidate>();
+}
+
+YAML::Node
+YAML::convert<gold::style_names>::encode(gold::style_names const & names)
+{
+    std::string text = names.tag;
+    for (auto const & name : names.classes) {
+        text += "." + name;
+    }
+    return YAML::Node{ text };
+}
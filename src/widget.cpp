@@ -1,31 +1,73 @@
 #include "gold/widget.hpp"
-#include "gold/layout.hpp"
-#include "gold/background_color.hpp"
-#include "gold/size.hpp"
+#include "gold/style.hpp"
+#include "gold/style_sheet.hpp"
 
 #include <fstream>
 #include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <entt/entity/registry.hpp>
 #include <yaml-cpp/yaml.h>
 
 namespace fs = std::filesystem;
+namespace {
+// a widget's own component, unless a style sheet wrote it, or its shared style
+template<typename component>
+component const * find_value(entt::registry const & widgets,
+                             entt::entity widget, bool styled)
+{
+    if (auto const * value = widgets.try_get<component>(widget);
+            value and not styled) {
+        return value;
+    }
+    if constexpr (gold::style_value<component>) {
+        using pool = gold::style_pool<component>;
+        auto const * shared = widgets.try_get<gold::shared<component>>(widget);
+        auto const * styles = widgets.ctx().find<pool>();
+        if (shared and styles) {
+            return &styles->get(shared->handle);
+        }
+    }
+    return nullptr;
+}
+
+template<typename component>
+bool write_value(YAML::Emitter & out, entt::registry const & widgets,
+                                      entt::entity widget, bool styled)
+{
+    auto const * value = find_value<component>(widgets, widget, styled);
+    if (not value) {
+        return false;
+    }
+    std::string_view constexpr key = gold::component_info<component>::key;
+    out << YAML::Key << std::string{ key }
+        << YAML::Value << YAML::Flow << YAML::Node{ *value };
+    return true;
+}
+}
+
 YAML::Emitter &
 gold::write(YAML::Emitter & out, entt::registry const & widgets,
                                  entt::entity widget)
 {
     out << YAML::Block << YAML::BeginMap;
-    if (auto const * layout = widgets.try_get<gold::layout>(widget)) {
-        out << YAML::Key << "align"
-            << YAML::Value << YAML::Flow << YAML::Node{ *layout };
-    }
-    if (auto const * size = widgets.try_get<gold::size>(widget)) {
-        out << YAML::Key << "size"
-            << YAML::Value << YAML::Flow << YAML::Node{ *size };
-    }
-    if (auto const * color = widgets.try_get<gold::background_color>(widget)) {
-        out << YAML::Key << "bg-color"
-            << YAML::Value << YAML::Flow << YAML::Node{ *color };
-    }
+    // components are written in their regular form, from the widget's own
+    // value, else its shared style, else its compact value, the same
+    // precedence as when rendering. Values a style sheet applied aren't the
+    // widget's own, and are applied again when it's restyled.
+    auto const * style = widgets.try_get<gold::computed_style>(widget);
+    gold::widget_components::for_each(
+        [&out, &widgets, widget, style]
+        <typename component, std::size_t index>()
+    {
+        using compact = decltype(gold::compact(std::declval<component>()));
+        bool const styled = style and style->applies(index);
+        if (not write_value<component>(out, widgets, widget, styled)) {
+            gold::detail::write_component<compact>(out, widgets, widget);
+        }
+    });
+    gold::detail::write_component<gold::style_names>(out, widgets, widget);
     return out << YAML::EndMap;
 }
 